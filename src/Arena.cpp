@@ -0,0 +1,58 @@
+#include "Arena.hpp"
+#include "Common/Assert.hpp"
+#include <algorithm>
+
+Arena::Arena(Arena&& other) noexcept
+  : blocks(std::move(other.blocks))
+  , destructors(std::move(other.destructors))
+  , current(std::exchange(other.current, nullptr))
+  , blockEnd(std::exchange(other.blockEnd, nullptr))
+  , bytesReserved(std::exchange(other.bytesReserved, 0))
+{}
+
+Arena::~Arena()
+{
+  this->destroyAll();
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept
+{
+  if (this != &other)
+  {
+    this->destroyAll();
+    this->blocks = std::move(other.blocks);
+    this->destructors = std::move(other.destructors);
+    this->current = std::exchange(other.current, nullptr);
+    this->blockEnd = std::exchange(other.blockEnd, nullptr);
+    this->bytesReserved = std::exchange(other.bytesReserved, 0);
+  }
+  return *this;
+}
+
+void Arena::destroyAll()
+{
+  for (auto it = this->destructors.rbegin(); it != this->destructors.rend(); ++it)
+    it->destroy(it->object);
+
+  this->destructors.clear();
+  this->blocks.clear();
+  this->current = nullptr;
+  this->blockEnd = nullptr;
+  this->bytesReserved = 0;
+}
+
+void* Arena::allocateSlow(size_t size, size_t alignment)
+{
+  release_assert(alignment <= alignof(std::max_align_t));
+
+  // blocks double in size as the arena grows, anything too big for that gets a block to itself
+  size_t blockSize = std::max(minimumBlockSize, std::min(this->bytesReserved, size_t(8) * 1024 * 1024));
+  blockSize = std::max(blockSize, size);
+
+  this->blocks.emplace_back(new char[blockSize]);
+  this->bytesReserved += blockSize;
+  this->current = this->blocks.back().get();
+  this->blockEnd = this->current + blockSize;
+
+  return this->allocate(size, alignment);
+}
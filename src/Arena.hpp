@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Common/Assert.hpp"
+
+// A fixed size list living in an Arena, made with Arena::makeList. Just a view, so it's cheap to copy, and it never
+// owns anything. Elements must be trivially copyable, in practice they're pointers to other nodes.
+template<typename T> class ArenaList
+{
+public:
+  ArenaList() = default;
+  ArenaList(T* data, uint32_t count) : data(data), count(count) {}
+
+  uint32_t size() const { return this->count; }
+  bool empty() const { return this->count == 0; }
+
+  T& operator[](size_t index) const { debug_assert(index < this->count); return this->data[index]; }
+
+  T* begin() const { return this->data; }
+  T* end() const { return this->data + this->count; }
+
+private:
+  T* data = nullptr;
+  uint32_t count = 0;
+};
+
+// Bump allocator for objects that all die together. Each object takes exactly its own size and alignment, packed
+// into large blocks. Destructors only get recorded for types that have one, and run in reverse order of creation
+// when the arena is destroyed. Objects never move, so pointers to them stay valid even if the arena is moved.
+class Arena
+{
+public:
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena(Arena&& other) noexcept;
+  ~Arena();
+  Arena& operator=(const Arena&) = delete;
+  Arena& operator=(Arena&& other) noexcept;
+
+  template<typename T, typename... Args> T* make(Args&&... args)
+  {
+    T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+      this->destructors.push_back(Destructor { .object = object, .destroy = [](void* p) { static_cast<T*>(p)->~T(); } });
+    return object;
+  }
+
+  template<typename T> ArenaList<T> makeList(const T* items, size_t count)
+  {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+    release_assert(count <= UINT32_MAX);
+
+    if (count == 0)
+      return ArenaList<T>();
+
+    T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    std::copy(items, items + count, data);
+    return ArenaList<T>(data, uint32_t(count));
+  }
+
+  // A new list with items added on the end. The old list is left as it was.
+  template<typename T> ArenaList<T> extendList(ArenaList<T> list, const T* items, size_t count)
+  {
+    std::vector<T> combined(list.begin(), list.end());
+    combined.insert(combined.end(), items, items + count);
+    return makeList(combined.data(), combined.size());
+  }
+
+  void* allocate(size_t size, size_t alignment)
+  {
+    uintptr_t aligned = (uintptr_t(this->current) + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (aligned + size > uintptr_t(this->blockEnd))
+      return allocateSlow(size, alignment);
+
+    this->current = reinterpret_cast<char*>(aligned + size);
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  size_t getBytesReserved() const { return this->bytesReserved; }
+
+private:
+  void* allocateSlow(size_t size, size_t alignment);
+  void destroyAll();
+
+  struct Destructor
+  {
+    void* object = nullptr;
+    void (*destroy)(void*) = nullptr;
+  };
+
+  static constexpr size_t minimumBlockSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::vector<Destructor> destructors;
+  char* current = nullptr;
+  char* blockEnd = nullptr;
+  size_t bytesReserved = 0;
+};
@@ -4,7 +4,7 @@
 template<typename T>
 T* Scope::lookup(ScopeId& name)
 {
-  HashMap<Item<T*>>* map = nullptr;
+  ScopeTable<Item<T*>>* map = nullptr;
   if constexpr (std::is_same<T, Func>::value)
     map = &this->functions;
   if constexpr (std::is_same<T, VariableDeclaration>::value)
@@ -12,11 +12,10 @@ T* Scope::lookup(ScopeId& name)
   if constexpr (std::is_same<T, Type>::value)
     map = &this->types;
 
-  auto it = map->find(name.str);
-  if (it != map->end())
+  if (Item<T*>* found = map->get(name.name))
   {
-    name.resolved = it->second.item;
-    return it->second.item;
+    name.resolved = found->item;
+    return found->item;
   }
 
   if (this->parent2)
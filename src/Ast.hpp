@@ -6,7 +6,10 @@
 #include <unordered_map>
 #include "Common/Assert.hpp"
 #include "Tokeniser.hpp"
-#include "HashMap.hpp"
+#include "Arena.hpp"
+#include "NodeArray.hpp"
+#include "Symbol.hpp"
+#include "ScopeTable.hpp"
 
 struct Root;
 struct FuncList;
@@ -34,16 +37,15 @@ struct ScopeId
   #include "CreateTaggedUnion.hpp"
 
   ScopeId() {}
-  ScopeId(std::string str): str(std::move(str)) {}
-  ScopeId(std::string str, Resolved resolved) : str(std::move(str)), resolved(std::move(resolved)) {}
-  ScopeId& operator=(std::string str) { this->str = std::move(str); return *this; }
+  ScopeId(Symbol name): name(name) {}
+  ScopeId(Symbol name, Resolved resolved) : name(name), resolved(std::move(resolved)) {}
 
   void resolveFunction(Scope& scope);
   void resolveVariableDeclaration(Scope& scope);
   void resolveType(Scope& scope);
 
 public:
-  std::string str;
+  Symbol name;
   Resolved resolved;
 };
 
@@ -59,7 +61,7 @@ struct TypeRef
 
 struct Type
 {
-  std::string name;
+  Symbol name;
   Class* typeClass = nullptr; // user defined types will have a class, builtins have only name
   bool builtin = false;
   bool builtinNumeric = false;
@@ -77,7 +79,7 @@ struct IntegerConstant
 
 struct StringConstant
 {
-  std::string val;
+  Symbol val;
 };
 
 class Null {};
@@ -90,23 +92,23 @@ public:
     XX(integerConstant, IntegerConstant, IntegerConstant) \
     XX(stringConstant, StringConstant, StringConstant) \
     XX(boolean, Bool, bool ) \
-    XX(op, Op, Op*) \
+    XX(op, Op, NodeRef<Op>) \
     XX(null, Null, Null)
   #define CLASS_NAME Val
   #include "CreateTaggedUnion.hpp"
 
   Val val;
-  TypeRef type;
-  SourceRange source;
+  TypeRef type = {};
+  SourceRange source = {};
 };
 
 
 #define FOR_EACH_TAGGED_UNION_TYPE(XX) \
-  XX(returnStatment, Return, ReturnStatement*) \
+  XX(returnStatment, Return, NodeRef<ReturnStatement>) \
   XX(variable, Variable, VariableDeclaration*) \
-  XX(assignment, Assignment, Assignment*) \
-  XX(expression, Expression, Expression*) \
-  XX(ifElseChain, IfElseChain, IfElseChain*)
+  XX(assignment, Assignment, NodeRef<Assignment>) \
+  XX(expression, Expression, NodeRef<Expression>) \
+  XX(ifElseChain, IfElseChain, NodeRef<IfElseChain>)
 #define CLASS_NAME Statement
 #include "CreateTaggedUnion.hpp"
 
@@ -119,54 +121,54 @@ struct Root
 struct FuncList
 {
   Scope* scope = nullptr;
-  std::vector<Func*> functions;
+  ArenaList<Func*> functions;
   std::vector<Class*> classes;
 };
 
 struct Func
 {
   TypeRef returnType;
-  std::string name;
-  std::string mangledName;
-  std::vector<VariableDeclaration*> args;
+  Symbol name;
+  Symbol mangledName;
+  ArenaList<VariableDeclaration*> args;
   bool external = false; // this is an extern function declaration, will be linked in from a non-wlang shared object
   Class* memberClass = nullptr; // if this function is a member of a class, this will be set
 
   // not set if external is true
   Scope* argsScope = nullptr;
-  Block* funcBody = nullptr;
+  NodeRef<Block> funcBody;
 };
 
 struct Class
 {
   Type* type = nullptr;
-  std::vector<VariableDeclaration*> memberVariables;
+  ArenaList<VariableDeclaration*> memberVariables;
   Scope* memberScope = nullptr;
 };
 
 struct Block
 {
-  std::vector<Statement*> statements;
+  ArenaList<NodeRef<Statement>> statements;
   Scope* scope = nullptr;
 };
 
 struct VariableDeclaration
 {
   TypeRef type;
-  std::string name;
+  Symbol name;
   SourceRange source;
-  Expression* initialiser = nullptr; // maybe null
+  NodeRef<Expression> initialiser; // maybe null
 };
 
 struct Assignment
 {
-  Expression* left = nullptr;
-  Expression* right = nullptr;
+  NodeRef<Expression> left;
+  NodeRef<Expression> right;
 };
 
 struct ReturnStatement
 {
-  Expression* retval = nullptr;
+  NodeRef<Expression> retval;
 };
 
 struct Op
@@ -192,30 +194,30 @@ struct Op
 
   struct Binary
   {
-    Expression* left = nullptr;
-    Expression* right = nullptr;
+    NodeRef<Expression> left;
+    NodeRef<Expression> right;
   };
 
   struct Unary
   {
-    Expression* expression = nullptr;
+    NodeRef<Expression> expression;
   };
 
   struct Call
   {
-    Expression* callable = nullptr;
-    std::vector<Expression*> callArgs;
+    NodeRef<Expression> callable;
+    ArenaList<NodeRef<Expression>> callArgs;
   };
 
   struct Subscript
   {
-    Expression* item = nullptr;
-    Expression* index = nullptr;
+    NodeRef<Expression> item;
+    NodeRef<Expression> index;
   };
 
   struct MemberAccess
   {
-    Expression* expression = nullptr;
+    NodeRef<Expression> expression;
     ScopeId member;
   };
 
@@ -234,13 +236,13 @@ struct Op
 
 struct IfElseChain
 {
-  std::vector<IfElseChainItem*> items;
+  ArenaList<NodeRef<IfElseChainItem>> items;
 };
 
 struct IfElseChainItem
 {
-  Expression* condition = nullptr;
-  Block* block = nullptr;
+  NodeRef<Expression> condition = {}; // null for a final else
+  NodeRef<Block> block;
 };
 
 struct Scope
@@ -255,9 +257,9 @@ struct Scope
     AstChunk* chunk;
   };
 
-  HashMap<Item<Func*>> functions;
-  HashMap<Item<VariableDeclaration*>> variables;
-  HashMap<Item<Type*>> types;
+  ScopeTable<Item<Func*>> functions;
+  ScopeTable<Item<VariableDeclaration*>> variables;
+  ScopeTable<Item<Type*>> types;
 
 private:
   template<typename T>
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <memory>
+#include <tuple>
 #include "Ast.hpp"
+#include "Arena.hpp"
+#include "LineTable.hpp"
+#include "Common/MappedFile.hpp"
 
 class AstChunk
 {
@@ -13,44 +18,46 @@ public:
   AstChunk& operator=(AstChunk&&) = default;
 
   template<typename T> T* makeNode();
+  template<typename T> NodeRef<T> addNode(T node = T()) { return std::get<NodeArray<T>>(this->nodeArrays).add(std::move(node)); }
+  template<typename T> T* get(NodeRef<T> ref) { return std::get<NodeArray<T>>(this->nodeArrays).get(ref); }
+  template<typename T> const T* get(NodeRef<T> ref) const { return std::get<NodeArray<T>>(this->nodeArrays).get(ref); }
+  template<typename T> ArenaList<T> makeList(const T* items, size_t count) { return this->nodes.makeList(items, count); }
+  template<typename T> ArenaList<T> extendList(ArenaList<T> list, const T* items, size_t count) { return this->nodes.extendList(list, items, count); }
+
+  const LineTable& getLineTable(); // built on first use, so files without diagnostics never pay for it
 
 public:
+  std::string path;
+  MappedFile sourceFile;
+  std::string_view source; // the contents of sourceFile, source ranges in the ast are offsets into this
   Root* root = nullptr;
 
 private:
-  #define FOR_EACH_TAGGED_UNION_TYPE(XX) \
-    XX(root, Root, Root) \
-    XX(funcList, FuncList, FuncList) \
-    XX(func, Func, Func) \
-    XX(block, Block, Block) \
-    XX(statement, Statement, Statement) \
-    XX(variableDeclaration, VariableDeclaration, VariableDeclaration) \
-    XX(assignment, Assignment, Assignment) \
-    XX(returnStatement, ReturnStatement, ReturnStatement) \
-    XX(type, Type, Type) \
-    XX(expression, Expression, Expression) \
-    XX(op, Op, Op) \
-    XX(classN, Class, Class) \
-    XX(ifElseChain, IfElseChain, IfElseChain) \
-    XX(ifElseChainItem, IfElseChainItem, IfElseChainItem) \
-    XX(scope, Scope, Scope)
-  #define CLASS_NAME Node
-  #include "CreateTaggedUnion.hpp"
-
-  using NodeBlock = std::vector<Node>;
-  std::vector<NodeBlock> nodeBlocks;
+  std::unique_ptr<LineTable> lineTable;
+
+  // Declarations get pointed to from other chunks once they're linked, so they're allocated individually from the
+  // arena and never move. Everything inside function bodies is only reachable from this chunk, so it's kept in an
+  // array per kind and linked together with 32 bit NodeRefs instead.
+  Arena nodes;
+  std::tuple<
+    NodeArray<Block>,
+    NodeArray<Statement>,
+    NodeArray<Assignment>,
+    NodeArray<ReturnStatement>,
+    NodeArray<IfElseChain>,
+    NodeArray<IfElseChainItem>,
+    NodeArray<Expression>,
+    NodeArray<Op>> nodeArrays;
 };
 
-template<typename T> T* AstChunk::makeNode()
+inline const LineTable& AstChunk::getLineTable()
 {
-  constexpr size_t blockSize = 256;
-  if (nodeBlocks.empty() || nodeBlocks.back().size() == blockSize)
-  {
-    nodeBlocks.resize(nodeBlocks.size() + 1);
-    nodeBlocks.back().reserve(blockSize);
-  }
-
-  NodeBlock& currentBlock = nodeBlocks.back();
-  Node& node = currentBlock.emplace_back(T());
-  return &node.get<T>();
+  if (!this->lineTable)
+    this->lineTable = std::make_unique<LineTable>(this->source);
+  return *this->lineTable;
 }
+
+template<typename T> T* AstChunk::makeNode()
+{
+  return this->nodes.make<T>();
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Runs func repeatedly for at least minimumSeconds, and returns the fastest run in seconds
+template <typename Func>
+double timeFastestRun(Func&& func, double minimumSeconds = 1.0)
+{
+  using Clock = std::chrono::steady_clock;
+
+  double fastest = 1e30;
+  double total = 0;
+  int32_t runs = 0;
+  while (total < minimumSeconds || runs < 3)
+  {
+    Clock::time_point start = Clock::now();
+    func();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    fastest = std::min(fastest, seconds);
+    total += seconds;
+    runs++;
+  }
+  return fastest;
+}
+
+inline double getMegabytesPerSecond(size_t bytes, double seconds)
+{
+  return double(bytes) / (1024.0 * 1024.0) / seconds;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include <cstring>
+#include <cstdio>
+#include "TokeniserBenchmark.hpp"
+#include "FrontEndBenchmark.hpp"
+#include "ParserBenchmark.hpp"
+#include "ScopeBenchmark.hpp"
+
+struct Benchmark
+{
+  const char* name;
+  void (*run)();
+};
+
+static const Benchmark benchmarks[] =
+{
+  {"tokeniser", benchmarkTokeniser},
+  {"frontend", benchmarkFrontEnd},
+  {"parser", benchmarkParser},
+  {"scopes", benchmarkScopes},
+};
+
+// Runs every benchmark, or just the ones named on the command line
+int main(int argc, char** argv)
+{
+  for (const Benchmark& benchmark : benchmarks)
+  {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc; i++)
+      selected = selected || strcmp(argv[i], benchmark.name) == 0;
+
+    if (selected)
+      benchmark.run();
+  }
+
+  return 0;
+}
\ No newline at end of file
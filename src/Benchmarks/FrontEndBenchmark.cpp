@@ -0,0 +1,51 @@
+#include "FrontEndBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "GenerateSource.hpp"
+#include "../SourceLoader.hpp"
+#include "../MergedAst.hpp"
+#include "../Parallel.hpp"
+#include "../Common/Assert.hpp"
+
+// Loads, parses and links a few thousand small files, with increasing thread counts
+void benchmarkFrontEnd()
+{
+  constexpr int32_t fileCount = 2000;
+  constexpr int32_t functionsPerFile = 10;
+
+  fs::path directory = fs::temp_directory_path() / "wlang_front_end_benchmark";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  std::vector<fs::path> paths;
+  size_t totalBytes = 0;
+  for (int32_t i = 0; i < fileCount; i++)
+  {
+    std::string source = generateSource(functionsPerFile, i * functionsPerFile);
+    totalBytes += source.size();
+
+    fs::path path = directory / ("file" + std::to_string(i) + ".w");
+    release_assert(overwriteFileWithString(path, source));
+    paths.emplace_back(std::move(path));
+  }
+
+  printf("front end on %d files, %.1f MB:\n", fileCount, double(totalBytes) / (1024.0 * 1024.0));
+
+  double singleThreadSeconds = 0;
+  for (int32_t threads = 1; threads <= getHardwareThreadCount(); threads *= 2)
+  {
+    double seconds = timeFastestRun([&]()
+    {
+      MergedAst mergedAst;
+      loadSources(paths, threads, [&](std::unique_ptr<AstChunk> chunk)
+      {
+        mergedAst.link(mergedAst.add(std::move(chunk)));
+      });
+    });
+
+    if (threads == 1)
+      singleThreadSeconds = seconds;
+    printf("  %d threads: %.1f MB/s (%.1fx)\n", threads, getMegabytesPerSecond(totalBytes, seconds), singleThreadSeconds / seconds);
+  }
+
+  fs::remove_all(directory);
+}
\ No newline at end of file
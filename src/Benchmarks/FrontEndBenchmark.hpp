@@ -0,0 +1,3 @@
+#pragma once
+
+void benchmarkFrontEnd();
\ No newline at end of file
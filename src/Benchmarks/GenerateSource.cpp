@@ -0,0 +1,53 @@
+#include "GenerateSource.hpp"
+
+std::string generateSource(int32_t functionCount, int32_t firstFunction)
+{
+  std::string source;
+  source.reserve(size_t(functionCount) * 700);
+
+  for (int32_t i = firstFunction; i < firstFunction + functionCount; i++)
+  {
+    std::string n = std::to_string(i);
+
+    source += "// generated block " + n + "\n";
+    source += "class Point" + n + "\n";
+    source += "{\n";
+    source += "  i32 x = " + n + ";\n";
+    source += "  i32 y = 0;\n";
+    source += "  i64 total = 0i64;\n";
+    source += "\n";
+    source += "  i32 sum(Point" + n + "* this, i32 scale) { return this.x * scale + this.y; }\n";
+    source += "}\n";
+    source += "\n";
+    source += "// function" + n + " mixes arithmetic with member access, then branches on the result so that every\n";
+    source += "// kind of statement shows up at least once\n";
+    source += "i32 function" + n + "(i32 a, i32 b, i8* buffer)\n";
+    source += "{\n";
+    source += "  i32 c = a + b * 3 - a / 2; // mixed precedence\n";
+    source += "  Point" + n + " point;\n";
+    source += "  point.y = c;\n";
+    source += "  bool one = a == 1;\n";
+    source += "  if (a == b && c != 0 || !one)\n";
+    source += "  {\n";
+    source += "    c = c + point.sum(a);\n";
+    source += "  }\n";
+    source += "  else if (a == " + n + ")\n";
+    source += "  {\n";
+    source += "    c = -c;\n";
+    source += "  }\n";
+    source += "  else if (a != b)\n";
+    source += "  {\n";
+    source += "    buffer[c] = 7i8;\n";
+    source += "  }\n";
+    source += "  point.total = 1234567i64;\n";
+    source += "  bool flag = true;\n";
+    source += "  i8* ptr = null;\n";
+    source += "  print(&\"function " + n + " says \\\"hello\\\"\");\n";
+    source += "  print(&\"a longer string, long enough that finding the closing quote is worth vectorising " + n + "\");\n";
+    source += "  return c;\n";
+    source += "}\n";
+    source += "\n";
+  }
+
+  return source;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// A large, valid wlang program, built by repeating classes and functions that use most of the language.
+// Expects the stdlib to be alongside it. Names are numbered from firstFunction, so several can be linked together.
+std::string generateSource(int32_t functionCount, int32_t firstFunction = 0);
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "ParserBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "GenerateSource.hpp"
+#include "TokeniserBenchmark.hpp"
+#include "../Parser.hpp"
+
+static double timeParse(const std::string& source)
+{
+  return timeFastestRun([&]()
+  {
+    AstChunk ast;
+    parse(ast, source);
+  });
+}
+
+// Parsing a large generated program, which includes tokenising it on the fly
+static void benchmarkParseCorpus()
+{
+  std::string source = generateSource(20000);
+  uint32_t tokenCount = countTokens(source);
+
+  double seconds = timeFastestRun([&]()
+  {
+    AstChunk ast;
+    parse(ast, source);
+  });
+
+  printf("tokenise and parse %.1f MB, %u tokens:\n", double(source.size()) / (1024.0 * 1024.0), tokenCount);
+  printf("  %.1f MB/s, %.1f M tokens/s\n", getMegabytesPerSecond(source.size(), seconds), double(tokenCount) / seconds / 1000000.0);
+}
+
+// Single expressions with lots of operands, which used to be quadratic to resolve
+void benchmarkParser()
+{
+  constexpr int32_t operandCount = 20000;
+  const char* operators[] = {" + ", " * ", " - ", " / ", " == ", " && ", " != ", " || "};
+
+  std::string arithmetic = "i32 f(i32 a, i32 b)\n{\n  i32 x = a";
+  for (int32_t i = 1; i < operandCount; i++)
+  {
+    arithmetic += operators[i % 8];
+    arithmetic += (i % 2) ? "b" : "a";
+  }
+  arithmetic += ";\n  return x;\n}\n";
+
+  std::string memberChain = "i32 f(i32 a)\n{\n  i32 x = a";
+  for (int32_t i = 1; i < operandCount; i++)
+    memberChain += ".m";
+  memberChain += ";\n  return x;\n}\n";
+
+  benchmarkParseCorpus();
+
+  printf("parse expressions with %d operands:\n", operandCount);
+  printf("  binary operators: %.2f ms\n", timeParse(arithmetic) * 1000.0);
+  printf("  member access chain: %.2f ms\n", timeParse(memberChain) * 1000.0);
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+void benchmarkParser();
\ No newline at end of file
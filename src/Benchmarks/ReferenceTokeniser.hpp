@@ -0,0 +1,36 @@
+#pragma once
+#include "../Tokeniser.hpp"
+
+namespace Reference
+{
+  // The old line/column positions and one struct per token representation
+  struct SourceLocation
+  {
+    int32_t y = -1;
+    int32_t x = -1;
+
+    SourceLocation() = default;
+    SourceLocation(int32_t x, int32_t y) : y(y), x(x) {}
+  };
+
+  struct SourceRange
+  {
+    SourceRange() = default;
+    SourceRange(SourceLocation start, SourceLocation end) : start(start), end(end) {}
+
+    SourceLocation start;
+    SourceLocation end;
+  };
+
+  struct Token
+  {
+    TokenType type = {};
+    std::string idValue = {};
+    IntegerToken integerValue = {};
+    std::string stringValue = {};
+
+    SourceRange source;
+  };
+
+  std::vector<Token> tokenise(std::string_view input);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "ScopeBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "../Parser.hpp"
+#include "../MergedAst.hpp"
+#include "../SemanticAnalyser.hpp"
+
+// Times just the name resolution pass, over sources parsed and linked as one file each
+static double timeResolveScopeIds(const std::vector<std::string>& sources)
+{
+  MergedAst mergedAst;
+  for (size_t i = 0; i < sources.size(); i++)
+  {
+    std::unique_ptr<AstChunk> chunk = std::make_unique<AstChunk>();
+    chunk->path = "scopes" + std::to_string(i) + ".w";
+    chunk->source = sources[i];
+    parse(*chunk, chunk->source);
+    mergedAst.link(mergedAst.add(std::move(chunk)));
+  }
+
+  SemanticAnalyser analyser;
+  return timeFastestRun([&]() { analyser.resolveScopeIds(mergedAst); });
+}
+
+// Lots of globals spread over several files, each calling a couple of others, so almost every lookup ends up in
+// the link scope
+static std::vector<std::string> generateGlobals(int32_t globalCount, int32_t fileCount)
+{
+  std::vector<std::string> sources(fileCount);
+  for (int32_t i = 0; i < globalCount; i++)
+  {
+    std::string& source = sources[i % fileCount];
+    std::string n = std::to_string(i);
+    source += "i32 global" + n + "(i32 a, i32 b)\n";
+    source += "{\n";
+    if (i < 2)
+    {
+      source += "  return a + b;\n";
+    }
+    else
+    {
+      source += "  i32 c = global" + std::to_string(i - 1) + "(a, b);\n";
+      source += "  i32 d = c + global" + std::to_string(i / 2) + "(b, a);\n";
+      source += "  return d * a - b;\n";
+    }
+    source += "}\n";
+  }
+  return sources;
+}
+
+// Functions made of blocks nested depth deep, each declaring one variable. The innermost block uses a variable
+// from every level, so lookups have to walk up through lots of small scopes.
+static std::vector<std::string> generateNestedBlocks(int32_t functionCount, int32_t depth)
+{
+  std::string source;
+  for (int32_t i = 0; i < functionCount; i++)
+  {
+    source += "i32 nested" + std::to_string(i) + "(i32 a)\n";
+    source += "{\n";
+    source += "  i32 v0 = a;\n";
+
+    std::string indent = "  ";
+    for (int32_t level = 1; level < depth; level++)
+    {
+      source += indent + "if (v" + std::to_string(level - 1) + " != 0)\n";
+      source += indent + "{\n";
+      indent += "  ";
+      source += indent + "i32 v" + std::to_string(level) + " = v" + std::to_string(level - 1) + " + a;\n";
+    }
+
+    source += indent + "a = v0";
+    for (int32_t level = 1; level < depth; level++)
+      source += " + v" + std::to_string(level);
+    source += ";\n";
+
+    for (int32_t level = depth - 1; level > 0; level--)
+    {
+      indent.resize(indent.size() - 2);
+      source += indent + "}\n";
+    }
+
+    source += "  return a;\n";
+    source += "}\n";
+  }
+  return { source };
+}
+
+void benchmarkScopes()
+{
+  constexpr int32_t globalCount = 50000;
+  constexpr int32_t globalFileCount = 50;
+  constexpr int32_t nestedFunctionCount = 200;
+  constexpr int32_t depth = 64;
+
+  printf("resolve names:\n");
+  printf("  %d globals in %d files: %.2f ms\n", globalCount, globalFileCount,
+         timeResolveScopeIds(generateGlobals(globalCount, globalFileCount)) * 1000.0);
+  printf("  %d functions with blocks nested %d deep: %.2f ms\n", nestedFunctionCount, depth,
+         timeResolveScopeIds(generateNestedBlocks(nestedFunctionCount, depth)) * 1000.0);
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+void benchmarkScopes();
\ No newline at end of file
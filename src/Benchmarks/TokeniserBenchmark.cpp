@@ -0,0 +1,180 @@
+#include "TokeniserBenchmark.hpp"
+#include "Benchmark.hpp"
+#include "GenerateSource.hpp"
+#include "ReferenceTokeniser.hpp"
+#include "../ScanKernels.hpp"
+#include "../LineTable.hpp"
+#include "../Common/Assert.hpp"
+#include <random>
+#include <string>
+
+static std::vector<Token> readAllTokens(std::string_view source)
+{
+  std::vector<Token> tokens;
+  TokenReader reader(source);
+  do
+  {
+    tokens.push_back(reader.pop());
+  } while (tokens.back().type != TokenType::End);
+  return tokens;
+}
+
+static void checkMatchesReference(const std::vector<Reference::Token>& expected, std::string_view source)
+{
+  std::vector<Token> actual = readAllTokens(source);
+  release_assert(expected.size() == actual.size());
+
+  TokenReader reader(source);
+  LineTable lines(source);
+
+  for (uint32_t i = 0; i < actual.size(); i++)
+  {
+    release_assert(expected[i].type == actual[i].type);
+    if (expected[i].type == TokenType::Id)
+      release_assert(expected[i].idValue == reader.getText(actual[i]));
+    if (expected[i].type == TokenType::IntegerToken)
+    {
+      release_assert(expected[i].integerValue.val == reader.getInteger(actual[i]).val);
+      release_assert(expected[i].integerValue.size == reader.getInteger(actual[i]).size);
+    }
+    if (expected[i].type == TokenType::String)
+      release_assert(expected[i].stringValue == reader.getText(actual[i]));
+
+    // The reference implementation's columns were off, as was the end token's line
+    if (i + 1 < actual.size())
+      release_assert(expected[i].source.start.y == lines.get(actual[i].source.start).line);
+  }
+}
+
+static void checkSameTokens(const std::vector<Token>& expected, const std::vector<Token>& actual)
+{
+  release_assert(expected.size() == actual.size());
+  for (size_t i = 0; i < expected.size(); i++)
+  {
+    release_assert(expected[i].type == actual[i].type);
+    release_assert(expected[i].source.start == actual[i].source.start);
+    release_assert(expected[i].source.end == actual[i].source.end);
+  }
+}
+
+// Every vector implementation must agree with the scalar one from every starting offset, including the tails that are
+// shorter than a vector
+static void checkScanKernels(Scan::Implementation implementation)
+{
+  std::mt19937 random(1234);
+  const char alphabet[] = "abcXYZ_09 \t\r\n\"\\/;{";
+
+  std::string buffer;
+  for (int32_t i = 0; i < 4096; i++)
+  {
+    // long runs of the same class, so the scans don't all stop on the first byte
+    char c = alphabet[random() % (sizeof(alphabet) - 1)];
+    buffer.append(random() % 40, c);
+  }
+
+  const char* end = buffer.data() + buffer.size();
+  for (const char* p = buffer.data(); p < end; p += 7)
+  {
+    Scan::setImplementation(Scan::Implementation::Scalar);
+    const char* expectedWhitespace = Scan::skipWhitespace(p, end);
+    const char* expectedIdentifier = Scan::skipIdentifier(p, end);
+    const char* expectedNewline = Scan::findNewline(p, end);
+    const char* expectedStringSpecial = Scan::findStringSpecial(p, end);
+
+    Scan::setImplementation(implementation);
+    release_assert(Scan::skipWhitespace(p, end) == expectedWhitespace);
+    release_assert(Scan::skipIdentifier(p, end) == expectedIdentifier);
+    release_assert(Scan::findNewline(p, end) == expectedNewline);
+    release_assert(Scan::findStringSpecial(p, end) == expectedStringSpecial);
+  }
+}
+
+uint32_t countTokens(std::string_view source)
+{
+  TokenReader reader(source);
+  uint32_t count = 1;
+  while (reader.pop().type != TokenType::End)
+    count++;
+  return count;
+}
+
+// Where the vector scans should pay off: documentation comments, long string constants and deep indentation. Not a
+// valid program, but every token in it is.
+static std::string generateLongRunsSource(size_t minimumSize)
+{
+  const std::string indent(24, ' ');
+  const std::string words = "the quick brown fox jumps over the lazy dog, ";
+
+  std::string source;
+  for (int32_t i = 0; source.size() < minimumSize; i++)
+  {
+    source += indent + "//";
+    for (int32_t j = 0; j < 3; j++)
+      source += " " + words;
+    source += "\n";
+
+    source += indent + "string s" + std::to_string(i) + " = \"";
+    for (int32_t j = 0; j < 3; j++)
+      source += words;
+    source += "\\n\";\n\n";
+  }
+  return source;
+}
+
+static void benchmarkLongRuns(Scan::Implementation best)
+{
+  std::string source = generateLongRunsSource(16 * 1024 * 1024);
+
+  Scan::setImplementation(Scan::Implementation::Scalar);
+  std::vector<Token> scalarTokens = readAllTokens(source);
+  printf("tokenise long comments, strings and indentation, %.1f MB:\n", double(source.size()) / (1024.0 * 1024.0));
+
+  double scalarSeconds = 0;
+  for (int32_t i = 0; i <= int32_t(best); i++)
+  {
+    Scan::Implementation implementation = Scan::Implementation(i);
+    Scan::setImplementation(implementation);
+    checkSameTokens(scalarTokens, readAllTokens(source));
+
+    double seconds = timeFastestRun([&]() { release_assert(countTokens(source) == scalarTokens.size()); });
+    if (implementation == Scan::Implementation::Scalar)
+      scalarSeconds = seconds;
+    printf("  %s: %.1f MB/s (%.1fx scalar)\n", Scan::getImplementationName(implementation), getMegabytesPerSecond(source.size(), seconds), scalarSeconds / seconds);
+  }
+}
+
+void benchmarkTokeniser()
+{
+  std::string source = generateSource(20000);
+
+  Scan::Implementation best = Scan::getBestImplementation();
+
+  Scan::setImplementation(Scan::Implementation::Scalar);
+  std::vector<Token> scalarTokens = readAllTokens(source);
+  checkMatchesReference(Reference::tokenise(source), source);
+
+  double referenceSeconds = timeFastestRun([&]() { Reference::tokenise(source); });
+  printf("tokenise on %.1f MB:\n", double(source.size()) / (1024.0 * 1024.0));
+  printf("  %zu bytes per token, reference used %zu plus heap allocated strings\n", sizeof(Token), sizeof(Reference::Token));
+  printf("  reference: %.1f MB/s\n", getMegabytesPerSecond(source.size(), referenceSeconds));
+
+  for (int32_t i = 0; i <= int32_t(best); i++)
+  {
+    Scan::Implementation implementation = Scan::Implementation(i);
+    checkScanKernels(implementation);
+
+    Scan::setImplementation(implementation);
+    checkSameTokens(scalarTokens, readAllTokens(source));
+
+    double seconds = timeFastestRun([&]() { release_assert(countTokens(source) == scalarTokens.size()); });
+    printf("  %s: %.1f MB/s (%.1fx)\n", Scan::getImplementationName(implementation), getMegabytesPerSecond(source.size(), seconds), referenceSeconds / seconds);
+  }
+
+  // only paid when a diagnostic is printed
+  double lineTableSeconds = timeFastestRun([&]() { LineTable lines(source); });
+  printf("  line table: %.1f MB/s\n", getMegabytesPerSecond(source.size(), lineTableSeconds));
+
+  benchmarkLongRuns(best);
+
+  Scan::setImplementation(Scan::getDefaultImplementation());
+}
\ No newline at end of file
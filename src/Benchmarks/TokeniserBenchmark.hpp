@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// Tokenises source with a TokenReader, counting the End token too
+uint32_t countTokens(std::string_view source);
+
+void benchmarkTokeniser();
\ No newline at end of file
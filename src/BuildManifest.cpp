@@ -0,0 +1,63 @@
+#include "BuildManifest.hpp"
+#include <sstream>
+#include <map>
+
+void BuildManifest::load(const fs::path& path)
+{
+  this->entries.clear();
+
+  std::string data;
+  if (!readWholeFileAsString(path, data))
+    return;
+
+  std::istringstream stream(data);
+  std::string name;
+  Entry entry;
+  while (stream >> name >> std::hex >> entry.sourceHash >> entry.commandHash)
+    this->entries.insert_or_assign(name, entry);
+}
+
+bool BuildManifest::save(const fs::path& path) const
+{
+  // sorted, so the file is stable and diffable
+  std::map<std::string_view, Entry> sorted(this->entries.begin(), this->entries.end());
+
+  std::string data;
+  for (const auto& pair : sorted)
+  {
+    char hashes[64];
+    snprintf(hashes, sizeof(hashes), " %016llx %016llx\n", (unsigned long long)pair.second.sourceHash, (unsigned long long)pair.second.commandHash);
+    data += pair.first;
+    data += hashes;
+  }
+
+  return overwriteFileWithString(path, data);
+}
+
+bool BuildManifest::isUpToDate(std::string_view objectName, const Entry& entry, const fs::path& objectPath) const
+{
+  auto it = this->entries.find(objectName);
+  if (it == this->entries.end() || it->second != entry)
+    return false;
+
+  std::error_code error;
+  return fs::exists(objectPath, error);
+}
+
+const BuildManifest::Entry* BuildManifest::get(std::string_view objectName) const
+{
+  auto it = this->entries.find(objectName);
+  return it == this->entries.end() ? nullptr : &it->second;
+}
+
+void BuildManifest::set(std::string_view objectName, const Entry& entry)
+{
+  this->entries.insert_or_assign(std::string(objectName), entry);
+}
+
+void BuildManifest::remove(std::string_view objectName)
+{
+  auto it = this->entries.find(objectName);
+  if (it != this->entries.end())
+    this->entries.erase(it);
+}
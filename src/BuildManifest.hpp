@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include "Common/Filesystem.hpp"
+#include "HashMap.hpp"
+
+// Records what went into each object file in the build directory, so unchanged objects can be reused on the next run.
+class BuildManifest
+{
+public:
+  struct Entry
+  {
+    uint64_t sourceHash = 0;
+    uint64_t commandHash = 0;
+
+    bool operator==(const Entry& other) const = default;
+  };
+
+  // A missing or unreadable manifest just means everything gets rebuilt
+  void load(const fs::path& path);
+  [[nodiscard]] bool save(const fs::path& path) const;
+
+  bool isUpToDate(std::string_view objectName, const Entry& entry, const fs::path& objectPath) const;
+  const Entry* get(std::string_view objectName) const;
+  void set(std::string_view objectName, const Entry& entry);
+  void remove(std::string_view objectName);
+
+private:
+  HashMap<Entry> entries;
+};
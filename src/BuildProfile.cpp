@@ -0,0 +1,40 @@
+#include "BuildProfile.hpp"
+
+const std::vector<BuildProfile>& BuildProfile::getAll()
+{
+  static const std::vector<BuildProfile> profiles
+  {
+    {.name = "debug",                   .optimisation = Optimisation::None,     .debugInfo = true,  .lto = LtoMode::None, .march = "",       .pgo = Pgo::None,     .profileDataPath = ""},
+    {.name = "release",                 .optimisation = Optimisation::MaxSpeed, .debugInfo = false, .lto = LtoMode::Thin, .march = "",       .pgo = Pgo::None,     .profileDataPath = ""},
+    {.name = "release-with-debug-info", .optimisation = Optimisation::Speed,    .debugInfo = true,  .lto = LtoMode::None, .march = "",       .pgo = Pgo::None,     .profileDataPath = ""},
+    {.name = "size",                    .optimisation = Optimisation::Size,     .debugInfo = false, .lto = LtoMode::Full, .march = "",       .pgo = Pgo::None,     .profileDataPath = ""},
+    {.name = "pgo-generate",            .optimisation = Optimisation::MaxSpeed, .debugInfo = false, .lto = LtoMode::None, .march = "",       .pgo = Pgo::Generate, .profileDataPath = ""},
+    {.name = "pgo-use",                 .optimisation = Optimisation::MaxSpeed, .debugInfo = false, .lto = LtoMode::Thin, .march = "",       .pgo = Pgo::Use,      .profileDataPath = ""},
+  };
+
+  return profiles;
+}
+
+const BuildProfile* BuildProfile::get(std::string_view name)
+{
+  for (const BuildProfile& profile : getAll())
+  {
+    if (profile.name == name)
+      return &profile;
+  }
+  return nullptr;
+}
+
+
+bool BuildProfile::parseLtoMode(std::string_view name, LtoMode& ltoMode)
+{
+  if (name == "none")
+    ltoMode = LtoMode::None;
+  else if (name == "full")
+    ltoMode = LtoMode::Full;
+  else if (name == "thin")
+    ltoMode = LtoMode::Thin;
+  else
+    return false;
+  return true;
+}
\ No newline at end of file
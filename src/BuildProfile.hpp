@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// A named set of code generation settings. Each profile builds into its own directory, so switching between them
+// doesn't throw away the other's objects.
+struct BuildProfile
+{
+  enum class Optimisation
+  {
+    None,
+    Speed,
+    MaxSpeed,
+    Size,
+  };
+
+  enum class LtoMode
+  {
+    None,
+    Full, // one monolithic link time optimisation pass, slowest but can optimise the most
+    Thin, // per-object summaries, parallel and cacheable, so relinking after a small edit stays fast
+  };
+
+  enum class Pgo
+  {
+    None,
+    Generate, // instrument the program, so running it records raw profiles into profileDataPath
+    Use,      // optimise using the merged profile at profileDataPath
+  };
+
+  std::string name;
+  Optimisation optimisation = Optimisation::None;
+  bool debugInfo = false;
+  LtoMode lto = LtoMode::None;
+  std::string march; // target cpu, empty means the compiler's portable default. "native" is opt in, via --march native
+  Pgo pgo = Pgo::None;
+  std::string profileDataPath; // filled in by the driver, depends on the project being built
+
+  std::string getBuildDirectoryName() const { return "build_" + name; }
+
+  static const std::vector<BuildProfile>& getAll();
+  static const BuildProfile* get(std::string_view name);
+  static bool parseLtoMode(std::string_view name, LtoMode& ltoMode);
+};
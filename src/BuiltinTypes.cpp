@@ -12,7 +12,7 @@ BuiltinTypes::BuiltinTypes()
   }
 }
 
-Type* BuiltinTypes::get(std::string_view name)
+Type* BuiltinTypes::get(Symbol name)
 {
   auto it = this->typeMap.find(name);
   return it == this->typeMap.end() ? nullptr : it->second;
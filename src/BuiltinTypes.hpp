@@ -10,19 +10,19 @@ struct BuiltinTypes
   Type tBool = make("bool");
   Type tNull = make("nullT");
 
-  Type* get(std::string_view name);
+  Type* get(Symbol name);
 
   static BuiltinTypes inst;
 
 public:
-  HashMap<Type*> typeMap;
+  SymbolMap<Type*> typeMap;
 
 public:
   static Type* resolveBinaryOperatorPromotion(Type* left, Type* right);
 
 private:
-  static Type make(std::string&& name) { return { .name = std::move(name), .builtin = true, }; }
-  static Type makeNumeric(std::string&& name) { return { .name = std::move(name), .builtin = true, .builtinNumeric = true }; }
+  static Type make(std::string_view name) { return { .name = Symbol(name), .builtin = true, }; }
+  static Type makeNumeric(std::string_view name) { return { .name = Symbol(name), .builtin = true, .builtinNumeric = true }; }
   BuiltinTypes();
 };
 
@@ -1,10 +1,32 @@
 #pragma once
 #include "Common/Filesystem.hpp"
+#include "Common/Assert.hpp"
+#include "BuildProfile.hpp"
 
 class CCompiler
 {
 public:
   virtual ~CCompiler() = default;
-  virtual void compile(const fs::path& cFilePath, const fs::path& objectFilePath) = 0;
-  virtual void linkExecutable(const std::vector<fs::path>& objects, const fs::path& outputPath) = 0;
-};
\ No newline at end of file
+  // The exact command line compile() will run, used to detect when objects need rebuilding because the flags changed.
+  // precompiledHeaderPath is optional, and must come from precompileHeader() with the same profile.
+  virtual std::vector<std::string> getCompileCommand(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath) = 0;
+
+  // Like getCompileCommand(), but the command reads the source from stdin instead of a file. Includes that would have
+  // been found next to the .c file are looked up in includeDirectory instead.
+  virtual bool supportsCompilingFromStdin() const { return false; }
+  virtual std::vector<std::string> getCompileFromStdinCommand(const BuildProfile&, const fs::path&, const fs::path&, const fs::path&) { message_and_abort("compiling from stdin not supported"); }
+
+  // Can be called concurrently from multiple threads. On failure, errorOutput receives the compiler's output, or the
+  // command line if it couldn't be run at all. The same goes for the other commands below.
+  [[nodiscard]] virtual bool compile(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, std::string& errorOutput) = 0;
+
+  virtual bool supportsPrecompiledHeaders() const { return false; }
+  virtual std::vector<std::string> getPrecompileHeaderCommand(const BuildProfile&, const fs::path&, const fs::path&) { message_and_abort("precompiled headers not supported"); }
+  [[nodiscard]] virtual bool precompileHeader(const BuildProfile&, const fs::path&, const fs::path&, std::string&) { message_and_abort("precompiled headers not supported"); }
+
+  virtual bool supportsProfileGuidedOptimisation() const { return false; }
+  // Combines the raw profiles written by a BuildProfile::Pgo::Generate build into one file for BuildProfile::Pgo::Use
+  [[nodiscard]] virtual bool mergeProfileData(const std::vector<fs::path>&, const fs::path&, std::string&) { message_and_abort("profile guided optimisation not supported"); }
+
+  [[nodiscard]] virtual bool linkExecutable(const BuildProfile& profile, const std::vector<fs::path>& objects, const fs::path& outputPath, std::string& errorOutput) = 0;
+};
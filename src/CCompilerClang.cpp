@@ -2,28 +2,145 @@
 #include "Process.hpp"
 #include "Common/Assert.hpp"
 
-void CCompilerClang::compile(const fs::path& cFilePath, const fs::path& objectFilePath)
+void CCompilerClang::addCodeGenerationFlags(const BuildProfile& profile, std::vector<std::string>& command)
 {
-  std::string output;
-  int32_t exitCode = 0;
-  release_assert(runProcess({this->compilerPath, "-g", "-c", cFilePath.string(), "-o", objectFilePath}, output, exitCode));
-  if (exitCode != 0)
-    message_and_abort(output.c_str());
+  switch (profile.optimisation)
+  {
+    case BuildProfile::Optimisation::None:
+      command.emplace_back("-O0");
+      break;
+    case BuildProfile::Optimisation::Speed:
+      command.emplace_back("-O2");
+      break;
+    case BuildProfile::Optimisation::MaxSpeed:
+      command.emplace_back("-O3");
+      break;
+    case BuildProfile::Optimisation::Size:
+      command.emplace_back("-Os");
+      break;
+  }
+
+  if (profile.debugInfo)
+    command.emplace_back("-g");
+  // objects become llvm bitcode, so inlining across our one-function-per-object files can happen at link time
+  switch (profile.lto)
+  {
+    case BuildProfile::LtoMode::None:
+      break;
+    case BuildProfile::LtoMode::Full:
+      command.emplace_back("-flto=full");
+      break;
+    case BuildProfile::LtoMode::Thin:
+      command.emplace_back("-flto=thin");
+      break;
+  }
+  if (!profile.march.empty())
+    command.emplace_back("-march=" + profile.march);
+}
+
+// Kept separate from addCodeGenerationFlags(), so precompiled headers can be shared between instrumented, profiled and
+// plain objects
+void CCompilerClang::addProfileFlags(const BuildProfile& profile, std::vector<std::string>& command)
+{
+  switch (profile.pgo)
+  {
+    case BuildProfile::Pgo::None:
+      break;
+    case BuildProfile::Pgo::Generate:
+      // %p is the pid, so concurrent runs don't clobber each other's output
+      command.emplace_back("-fprofile-instr-generate=" + (fs::path(profile.profileDataPath) / "wlang-%p.profraw").string());
+      break;
+    case BuildProfile::Pgo::Use:
+      command.emplace_back("-fprofile-instr-use=" + profile.profileDataPath);
+      break;
+  }
+}
+
+std::vector<std::string> CCompilerClang::getCompileCommand(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath)
+{
+  std::vector<std::string> command = {this->compilerPath};
+  addCodeGenerationFlags(profile, command);
+  addProfileFlags(profile, command);
+  command.insert(command.end(), {"-c", cFilePath.string(), "-o", objectFilePath.string()});
+
+  if (!precompiledHeaderPath.empty())
+  {
+    command.emplace_back("-include-pch");
+    command.emplace_back(precompiledHeaderPath.string());
+  }
+  return command;
+}
+
+std::vector<std::string> CCompilerClang::getCompileFromStdinCommand(const BuildProfile& profile, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, const fs::path& includeDirectory)
+{
+  std::vector<std::string> command = {this->compilerPath};
+  addCodeGenerationFlags(profile, command);
+  addProfileFlags(profile, command);
+  command.insert(command.end(), {"-I", includeDirectory.string(), "-x", "c", "-c", "-", "-o", objectFilePath.string()});
+
+  if (!precompiledHeaderPath.empty())
+  {
+    command.emplace_back("-include-pch");
+    command.emplace_back(precompiledHeaderPath.string());
+  }
+  return command;
+}
+
+bool CCompilerClang::compile(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, std::string& errorOutput)
+{
+  return runTool(this->getCompileCommand(profile, cFilePath, objectFilePath, precompiledHeaderPath), errorOutput);
 }
 
-void CCompilerClang::linkExecutable(const std::vector<fs::path>& objects, const fs::path& outputPath)
+std::vector<std::string> CCompilerClang::getPrecompileHeaderCommand(const BuildProfile& profile, const fs::path& headerPath, const fs::path& precompiledHeaderPath)
+{
+  // needs the same code generation flags as getCompileCommand(), or clang will refuse to use the result
+  std::vector<std::string> command = {this->compilerPath};
+  addCodeGenerationFlags(profile, command);
+  command.insert(command.end(), {"-x", "c-header", headerPath.string(), "-o", precompiledHeaderPath.string()});
+  return command;
+}
+
+bool CCompilerClang::precompileHeader(const BuildProfile& profile, const fs::path& headerPath, const fs::path& precompiledHeaderPath, std::string& errorOutput)
+{
+  return runTool(this->getPrecompileHeaderCommand(profile, headerPath, precompiledHeaderPath), errorOutput);
+}
+
+bool CCompilerClang::linkExecutable(const BuildProfile& profile, const std::vector<fs::path>& objects, const fs::path& outputPath, std::string& errorOutput)
 {
   std::vector<std::string> command;
-  command.reserve(objects.size() + 3);
+  command.reserve(objects.size() + 8);
   command.emplace_back(this->compilerPath);
+
+  // with LTO, code generation happens at link time, so it needs the same flags again
+  addCodeGenerationFlags(profile, command);
+  // pulls in the profiling runtime for instrumented builds
+  addProfileFlags(profile, command);
+
+  if (profile.lto != BuildProfile::LtoMode::None)
+  {
+    // the system linker may not have the llvm plugin needed to read bitcode objects, lld always can
+    command.emplace_back("-fuse-ld=lld");
+
+    // reuses the optimised output of modules whose inputs didn't change, so an edit to one function doesn't
+    // re-optimise the whole program
+    if (profile.lto == BuildProfile::LtoMode::Thin)
+      command.emplace_back("-Wl,--thinlto-cache-dir=" + (outputPath.parent_path() / "thinlto_cache").string());
+  }
+
   for (const fs::path& object : objects)
     command.emplace_back(object.string());
   command.emplace_back("-o");
   command.emplace_back(outputPath);
 
-  std::string output;
-  int32_t exitCode = 0;
-  release_assert(runProcess(command, output, exitCode));
-  if (exitCode != 0)
-    message_and_abort(output.c_str());
+  return runTool(command, errorOutput);
 }
+
+
+bool CCompilerClang::mergeProfileData(const std::vector<fs::path>& rawProfilePaths, const fs::path& outputPath, std::string& errorOutput)
+{
+  std::vector<std::string> command = {this->profileDataToolPath, "merge", "-o", outputPath.string()};
+  for (const fs::path& path : rawProfilePaths)
+    command.emplace_back(path.string());
+
+  return runTool(command, errorOutput);
+}
\ No newline at end of file
@@ -5,9 +5,24 @@ class CCompilerClang : public CCompiler
 {
 public:
   ~CCompilerClang() override = default;
-  void compile(const fs::path& cFilePath, const fs::path& objectFilePath) override;
-  void linkExecutable(const std::vector<fs::path>& objects, const fs::path& outputPath) override;
+  std::vector<std::string> getCompileCommand(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath) override;
+  bool supportsCompilingFromStdin() const override { return true; }
+  std::vector<std::string> getCompileFromStdinCommand(const BuildProfile& profile, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, const fs::path& includeDirectory) override;
+  [[nodiscard]] bool compile(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, std::string& errorOutput) override;
+
+  bool supportsPrecompiledHeaders() const override { return true; }
+  std::vector<std::string> getPrecompileHeaderCommand(const BuildProfile& profile, const fs::path& headerPath, const fs::path& precompiledHeaderPath) override;
+  [[nodiscard]] bool precompileHeader(const BuildProfile& profile, const fs::path& headerPath, const fs::path& precompiledHeaderPath, std::string& errorOutput) override;
+  bool supportsProfileGuidedOptimisation() const override { return true; }
+  [[nodiscard]] bool mergeProfileData(const std::vector<fs::path>& rawProfilePaths, const fs::path& outputPath, std::string& errorOutput) override;
+
+  [[nodiscard]] bool linkExecutable(const BuildProfile& profile, const std::vector<fs::path>& objects, const fs::path& outputPath, std::string& errorOutput) override;
+
+private:
+  static void addCodeGenerationFlags(const BuildProfile& profile, std::vector<std::string>& command);
+  static void addProfileFlags(const BuildProfile& profile, std::vector<std::string>& command);
 
 private:
   std::string compilerPath = "/usr/bin/clang";
-};
\ No newline at end of file
+  std::string profileDataToolPath = "/usr/bin/llvm-profdata";
+};
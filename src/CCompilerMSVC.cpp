@@ -42,27 +42,52 @@ CCompilerMSVC::CCompilerMSVC()
   FreeEnvironmentStringsW(baseEnvironment);
 }
 
-void CCompilerMSVC::compile(const fs::path& cFilePath, const fs::path& objectFilePath)
+std::vector<std::string> CCompilerMSVC::getCompileCommand(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath)
 {
-  std::string output;
-  int32_t exitCode = 0;
-  release_assert(runProcess({compilerPath.string(), "/Fo" + objectFilePath.string(), "/c", cFilePath.string()}, output, exitCode));
-  if (exitCode != 0)
-    message_and_abort(output.c_str());
+  release_assert(precompiledHeaderPath.empty());
+
+  std::vector<std::string> command = {compilerPath.string()};
+  switch (profile.optimisation)
+  {
+    case BuildProfile::Optimisation::None:
+      command.emplace_back("/Od");
+      break;
+    case BuildProfile::Optimisation::Speed:
+    case BuildProfile::Optimisation::MaxSpeed:
+      command.emplace_back("/O2");
+      break;
+    case BuildProfile::Optimisation::Size:
+      command.emplace_back("/O1");
+      break;
+  }
+
+  if (profile.debugInfo)
+    command.emplace_back("/Z7");
+  // MSVC only has the one kind of whole program optimisation, so thin and full both map to it
+  if (profile.lto != BuildProfile::LtoMode::None)
+    command.emplace_back("/GL");
+  // MSVC has no equivalent of -march=native, and only takes a few fixed /arch values, so march is ignored
+
+  command.insert(command.end(), {"/Fo" + objectFilePath.string(), "/c", cFilePath.string()});
+  return command;
 }
 
-void CCompilerMSVC::linkExecutable(const std::vector<fs::path>& objects, const fs::path& outputPath)
+bool CCompilerMSVC::compile(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, std::string& errorOutput)
 {
-  std::string output;
-  int32_t exitCode = 0;
+  return runTool(this->getCompileCommand(profile, cFilePath, objectFilePath, precompiledHeaderPath), errorOutput);
+}
 
+bool CCompilerMSVC::linkExecutable(const BuildProfile& profile, const std::vector<fs::path>& objects, const fs::path& outputPath, std::string& errorOutput)
+{
   std::vector<std::string> args = {linkerPath.string(), "/OUT:" + outputPath.string()};
+  if (profile.debugInfo)
+    args.emplace_back("/DEBUG");
+  if (profile.lto != BuildProfile::LtoMode::None)
+    args.emplace_back("/LTCG");
   for (const fs::path& item : objects)
     args.emplace_back(item.string());
 
-  release_assert(runProcess(args, output, exitCode, this->evironmentBlock.data()));
-  if (exitCode != 0)
-    message_and_abort(output.c_str());
+  return runTool(args, errorOutput, this->evironmentBlock.data());
 }
 
 #endif
\ No newline at end of file
@@ -8,8 +8,9 @@ public:
   CCompilerMSVC();
   ~CCompilerMSVC() override = default;
 
-  void compile(const fs::path& cFilePath, const fs::path& objectFilePath) override;
-  void linkExecutable(const std::vector<fs::path>& objects, const fs::path& outputPath) override;
+  std::vector<std::string> getCompileCommand(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath) override;
+  [[nodiscard]] bool compile(const BuildProfile& profile, const fs::path& cFilePath, const fs::path& objectFilePath, const fs::path& precompiledHeaderPath, std::string& errorOutput) override;
+  [[nodiscard]] bool linkExecutable(const BuildProfile& profile, const std::vector<fs::path>& objects, const fs::path& outputPath, std::string& errorOutput) override;
 
 private:
   fs::path compilerPath;
@@ -5,98 +5,97 @@
 // NB! this is called before type resolution
 void generateClassDefaults(AstChunk& ast)
 {
+  std::vector<Func*> defaultConstructors;
   for (Class* classN : ast.root->funcList->classes)
   {
     Func* func = ast.makeNode<Func>();
     func->argsScope = ast.makeNode<Scope>();
     {
       VariableDeclaration* thisDeclaration = ast.makeNode<VariableDeclaration>();
-      thisDeclaration->name = "this";
+      thisDeclaration->name = Symbol("this");
       thisDeclaration->type = classN->type->reference();
       thisDeclaration->type.pointerDepth = 1;
 
-      func->args.emplace_back(thisDeclaration);
-      func->argsScope->variables.insert_or_assign(thisDeclaration->name, Scope::Item<VariableDeclaration*>{.item = thisDeclaration, .chunk = &ast});
+      func->args = ast.makeList(&thisDeclaration, 1);
+      func->argsScope->variables.set(thisDeclaration->name, Scope::Item<VariableDeclaration*>{.item = thisDeclaration, .chunk = &ast});
     }
 
 
     func->returnType = BuiltinTypes::inst.tI32.reference(); // TODO: replace when I add void
-    func->name = "defaultConstruct";
+    func->name = Symbol("defaultConstruct");
 
     {
-      Block* block = ast.makeNode<Block>();
+      NodeRef<Block> blockRef = ast.addNode<Block>();
+      Block* block = ast.get(blockRef);
       block->scope = ast.makeNode<Scope>();
       block->scope->parent = ast.root->funcList->scope;
 
+      std::vector<NodeRef<Statement>> statements;
+
       for (VariableDeclaration* variableDeclaration : classN->memberVariables)
       {
         if (variableDeclaration->initialiser)
         {
-          Statement* statement = ast.makeNode<Statement>();
-          Assignment* assignment = ast.makeNode<Assignment>();
-
-          assignment->left = ast.makeNode<Expression>();
+          NodeRef<Expression> left;
           {
-            Op* op = ast.makeNode<Op>();
-            op->type = Op::Type::MemberAccess;
-
-            Expression* thisExpression = ast.makeNode<Expression>();
-            thisExpression->val = ScopeId("this");
-
-            op->args = Op::MemberAccess{.expression = thisExpression, .member = ScopeId(variableDeclaration->name)};
-            assignment->left->val = op;
+            NodeRef<Expression> thisExpression = ast.addNode(Expression { .val = ScopeId(Symbol("this")) });
+
+            NodeRef<Op> op = ast.addNode(Op
+            {
+              .type = Op::Type::MemberAccess,
+              .args = Op::MemberAccess{.expression = thisExpression, .member = ScopeId(variableDeclaration->name)},
+            });
+            left = ast.addNode(Expression { .val = op });
           }
 
-          assignment->right = variableDeclaration->initialiser;
-
-          *statement = assignment;
-          block->statements.emplace_back(statement);
+          NodeRef<Assignment> assignment = ast.addNode(Assignment { .left = left, .right = variableDeclaration->initialiser });
+          statements.emplace_back(ast.addNode(Statement(assignment)));
         }
         else
         {
-          Expression* memberExpression = ast.makeNode<Expression>();
+          NodeRef<Expression> memberExpression;
           {
-            Expression* thisExpression = ast.makeNode<Expression>();
-            thisExpression->val = ScopeId("this");
-
-            Op* op = ast.makeNode<Op>();
-            op->type = Op::Type::MemberAccess;
-            op->args = Op::MemberAccess{.expression = thisExpression, .member = ScopeId(variableDeclaration->name)};
-
-            memberExpression->val = op;
+            NodeRef<Expression> thisExpression = ast.addNode(Expression { .val = ScopeId(Symbol("this")) });
+
+            NodeRef<Op> op = ast.addNode(Op
+            {
+              .type = Op::Type::MemberAccess,
+              .args = Op::MemberAccess{.expression = thisExpression, .member = ScopeId(variableDeclaration->name)},
+            });
+            memberExpression = ast.addNode(Expression { .val = op });
           }
 
-          Expression* constructorExpression = ast.makeNode<Expression>();
+          NodeRef<Expression> constructorExpression;
           {
-            Op* op = ast.makeNode<Op>();
-            op->type = Op::Type::MemberAccess;
-            op->args = Op::MemberAccess{.expression = memberExpression, .member = ScopeId("defaultConstruct")};
-            constructorExpression->val = op;
+            NodeRef<Op> op = ast.addNode(Op
+            {
+              .type = Op::Type::MemberAccess,
+              .args = Op::MemberAccess{.expression = memberExpression, .member = ScopeId(Symbol("defaultConstruct"))},
+            });
+            constructorExpression = ast.addNode(Expression { .val = op });
           }
 
-          Expression* callExpression = ast.makeNode<Expression>();
+          NodeRef<Expression> callExpression;
           {
-            Op* op = ast.makeNode<Op>();
-            op->type = Op::Type::Call;
-            op->args = Op::Call {.callable = constructorExpression, .callArgs = {}};
-            callExpression->val = op;
+            NodeRef<Op> op = ast.addNode(Op { .type = Op::Type::Call, .args = Op::Call {.callable = constructorExpression, .callArgs = {}} });
+            callExpression = ast.addNode(Expression { .val = op });
           }
 
-          Statement* statement = ast.makeNode<Statement>();
-          *statement = callExpression;
-
-          block->statements.emplace_back(statement);
+          statements.emplace_back(ast.addNode(Statement(callExpression)));
         }
       }
 
-      func->funcBody = block;
+      block->statements = ast.makeList(statements.data(), statements.size());
+      block->scope->parent2 = func->argsScope;
+      func->funcBody = blockRef;
     }
 
-    func->funcBody->scope->parent2 = func->argsScope;
+    defaultConstructors.emplace_back(func);
 
-    ast.root->funcList->functions.emplace_back(func);
-
-    classN->memberScope->functions.insert_or_assign(func->name, Scope::Item<Func*>{.item = func, .chunk = &ast});
+    classN->memberScope->functions.set(func->name, Scope::Item<Func*>{.item = func, .chunk = &ast});
     func->memberClass = classN;
   }
+
+  FuncList* funcList = ast.root->funcList;
+  funcList->functions = ast.extendList(funcList->functions, defaultConstructors.data(), defaultConstructors.size());
 }
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a. These hashes get persisted between runs, so unlike std::hash they must be stable across builds and platforms.
+inline uint64_t hashString(std::string_view str, uint64_t hash = 14695981039346656037ULL)
+{
+  for (char c : str)
+  {
+    hash ^= uint8_t(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
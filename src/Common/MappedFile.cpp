@@ -0,0 +1,113 @@
+#include "MappedFile.hpp"
+#include <utility>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+MappedFile::~MappedFile()
+{
+  this->close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  this->close();
+  this->data = std::exchange(other.data, nullptr);
+  this->size = std::exchange(other.size, 0);
+  return *this;
+}
+
+bool MappedFile::open(const fs::path& path)
+{
+  this->close();
+
+#ifdef WIN32
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  if (fileSize.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return true;
+  }
+
+  // the view keeps the mapping and file alive, so the handles can go straight away
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping)
+    return false;
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view)
+    return false;
+
+  this->data = (const char*)view;
+  this->size = size_t(fileSize.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return false;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  if (fileStat.st_size == 0)
+  {
+    ::close(fd);
+    return true;
+  }
+
+  // the mapping keeps its own reference to the file
+  void* mapped = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    return false;
+
+  // it's about to be read front to back, so start paging it in now
+  madvise(mapped, size_t(fileStat.st_size), MADV_WILLNEED);
+
+  this->data = (const char*)mapped;
+  this->size = size_t(fileStat.st_size);
+#endif
+
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (!this->data)
+    return;
+
+#ifdef WIN32
+  UnmapViewOfFile(this->data);
+#else
+  munmap((void*)this->data, this->size);
+#endif
+
+  this->data = nullptr;
+  this->size = 0;
+}
\ No newline at end of file
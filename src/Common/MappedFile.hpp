@@ -0,0 +1,26 @@
+#pragma once
+#include <string_view>
+#include "Filesystem.hpp"
+
+// A whole file mapped read only into memory. Views of the contents stay valid until the MappedFile is destroyed,
+// including across moves.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  ~MappedFile();
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  [[nodiscard]] bool open(const fs::path& path);
+  std::string_view getContents() const { return std::string_view(this->data, this->size); }
+
+private:
+  void close();
+
+private:
+  const char* data = nullptr; // null for empty files, which can't be mapped
+  size_t size = 0;
+};
\ No newline at end of file
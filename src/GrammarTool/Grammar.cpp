@@ -1,4 +1,3 @@
-#include <functional>
 #include <sstream>
 #include "Grammar.hpp"
 #include "../Common/StringUtil.hpp"
@@ -184,6 +183,7 @@ static GrammarResult make_grammar(const std::string& str_table)
         const std::string* returnTypeToken = nullptr;
         const std::string* argumentsToken = nullptr;
         const std::string* codeBeforeToken = nullptr;
+        bool loopsOnTailCall = false;
 
         while (true)
         {
@@ -202,6 +202,11 @@ static GrammarResult make_grammar(const std::string& str_table)
           {
             break;
           }
+          else if (tokens[i] == "loop")
+          {
+            release_assert(!loopsOnTailCall);
+            loopsOnTailCall = true;
+          }
           else if (tokens[i].starts_with("{{"))
           {
             release_assert(!codeBeforeToken);
@@ -214,7 +219,7 @@ static GrammarResult make_grammar(const std::string& str_table)
           }
         }
 
-        NonTerminal& newRule = rules.rules[ruleStartToken] = NonTerminal { .name = ruleStartToken };
+        NonTerminal& newRule = rules.rules[ruleStartToken] = NonTerminal { .name = ruleStartToken, .loopsOnTailCall = loopsOnTailCall };
         rules.keys.emplace_back(ruleStartToken);
         currentRuleName = ruleStartToken;
 
@@ -304,174 +309,335 @@ Grammar::Grammar(const std::string& str_table)
   this->keys = std::move(result.keys);
 
   release_assert(this->rules.size() == this->keys.size());
-  for (const std::string& key : this->keys)
-    this->can_be_nil(key);
+  this->computeSets();
 }
 
-bool Grammar::can_be_nil(const std::string& name) const
+// One bit per terminal
+using TerminalSet = std::vector<uint64_t>;
+
+static bool setBit(TerminalSet& set, int32_t index)
+{
+  uint64_t bit = uint64_t(1) << (index % 64);
+  bool changed = !(set[index / 64] & bit);
+  set[index / 64] |= bit;
+  return changed;
+}
+
+static bool unionInto(TerminalSet& target, const TerminalSet& source)
 {
-  for (const Production& production : this->rules.at(name).productions)
+  bool changed = false;
+  for (size_t i = 0; i < target.size(); i++)
   {
-    if (production[0] == "Nil")
-      return true;
+    uint64_t merged = target[i] | source[i];
+    changed |= merged != target[i];
+    target[i] = merged;
+  }
+  return changed;
+}
+
+void Grammar::computeSets()
+{
+  int32_t ruleCount = int32_t(this->keys.size());
+
+  std::vector<const NonTerminal*> ruleList;
+  std::unordered_map<const NonTerminal*, int32_t> ruleIndices;
+  for (int32_t i = 0; i < ruleCount; i++)
+  {
+    ruleList.emplace_back(&this->rules.at(this->keys[i]));
+    ruleIndices[ruleList.back()] = i;
+  }
 
-    if (production[0].isNonTerminal())
+  std::vector<std::string> terminals;
+  std::unordered_map<std::string, int32_t> terminalIndices;
+  for (const NonTerminal* rule : ruleList)
+  {
+    for (const Production& production : rule->productions)
     {
-      Production test_prod = production;
-      while (true)
+      for (const ProductionItem& item : production)
       {
-          if (!test_prod[0].isNonTerminal())
-              break;
-          if (!this->can_be_nil(test_prod[0].nonTerminal().name))
-              break;
+        if (item.isStr() && item != "Nil" && terminalIndices.try_emplace(item.str(), int32_t(terminals.size())).second)
+          terminals.emplace_back(item.str());
+      }
+    }
+  }
 
-          test_prod.erase(test_prod.begin());
+  size_t wordCount = (terminals.size() + 63) / 64;
 
-          if (test_prod.empty())
-              return true;
+  // rules that mention each rule in one of their productions, so need revisiting when it changes
+  std::vector<std::vector<int32_t>> dependents(ruleCount);
+  for (int32_t r = 0; r < ruleCount; r++)
+  {
+    for (const Production& production : ruleList[r]->productions)
+    {
+      for (const ProductionItem& item : production)
+      {
+        if (item.isNonTerminal())
+          dependents[ruleIndices.at(&item.nonTerminal())].emplace_back(r);
       }
     }
   }
 
-  return false;
-}
+  std::vector<int32_t> worklist;
+  std::vector<bool> queued(ruleCount, true);
+  auto queueAll = [&]()
+  {
+    for (int32_t r = ruleCount - 1; r >= 0; r--)
+      worklist.emplace_back(r);
+    std::fill(queued.begin(), queued.end(), true);
+  };
 
-std::vector<std::vector<std::string>> Grammar::first(const std::string& name) const
-{
-  std::vector<std::vector<std::string>> retval;
-  for (const Production& production : this->rules.at(name).productions)
+  // nullable and FIRST
+  std::vector<bool> nullable(ruleCount, false);
+  std::vector<TerminalSet> firstSets(ruleCount, TerminalSet(wordCount, 0));
+  queueAll();
+  while (!worklist.empty())
   {
-    std::vector<std::string> prod_firsts;
-    auto prod_firsts_append = [&](const std::string& sym)
-    {
-      if (sym == "Nil")
-        return;
-      prod_firsts.emplace_back(sym);
-    };
+    int32_t r = worklist.back();
+    worklist.pop_back();
+    queued[r] = false;
 
-    for (int32_t i = 0; i < int32_t(production.size()); i++)
+    bool changed = false;
+    for (const Production& production : ruleList[r]->productions)
     {
-      if (!production[i].isNonTerminal())
+      bool productionNullable = true;
+      for (const ProductionItem& item : production)
       {
-        prod_firsts_append(production[i].str());
-        break;
-      }
+        if (item == "Nil")
+          break;
 
-      const NonTerminal& nonTerminal = production[i].nonTerminal();
+        if (item.isStr())
+        {
+          changed |= setBit(firstSets[r], terminalIndices.at(item.str()));
+          productionNullable = false;
+          break;
+        }
 
-      for (const std::vector<std::string>& x : this->first(nonTerminal.name))
-      {
-        for (const std::string& item: x)
-          prod_firsts_append(item);
+        int32_t other = ruleIndices.at(&item.nonTerminal());
+        changed |= unionInto(firstSets[r], firstSets[other]);
+        if (!nullable[other])
+        {
+          productionNullable = false;
+          break;
+        }
       }
 
-      if (!this->can_be_nil(nonTerminal.name))
-        break;
+      if (productionNullable && !nullable[r])
+      {
+        nullable[r] = true;
+        changed = true;
+      }
     }
 
-    retval.emplace_back(std::move(prod_firsts));
+    if (changed)
+    {
+      for (int32_t dependent : dependents[r])
+      {
+        if (!queued[dependent])
+        {
+          queued[dependent] = true;
+          worklist.emplace_back(dependent);
+        }
+      }
+    }
   }
 
-  // check for duplicates
+  // FOLLOW. Walking each production backwards gives the FIRST set of what comes after each item directly, and
+  // when everything after an item can be nil, the rule's own FOLLOW set flows into the item's.
+  std::vector<TerminalSet> followSets(ruleCount, TerminalSet(wordCount, 0));
+  std::vector<std::vector<int32_t>> followEdges(ruleCount);
+  for (int32_t r = 0; r < ruleCount; r++)
   {
-    std::unordered_set<std::string> tmp;
-    for (const std::vector<std::string>& x: retval)
+    for (const Production& production : ruleList[r]->productions)
     {
-      for (const std::string& item: x)
+      TerminalSet suffixFirst(wordCount, 0);
+      bool suffixNullable = true;
+      for (int32_t i = int32_t(production.size()) - 1; i >= 0; i--)
       {
-        if (tmp.contains(item))
+        const ProductionItem& item = production[i];
+        if (item == "Nil")
+          continue;
+
+        if (item.isStr())
         {
-          fprintf(stderr, "Duplicate first in %s\n", name.c_str());
-          for (const std::vector<std::string>& x2: retval)
-          {
-            fprintf(stderr, "    ");
-            for (const std::string& item2: x2)
-            {
-              fprintf(stderr, "%s ", item2.c_str());
-            }
-            fprintf(stderr, "\n");
-          }
+          std::fill(suffixFirst.begin(), suffixFirst.end(), 0);
+          setBit(suffixFirst, terminalIndices.at(item.str()));
+          suffixNullable = false;
+          continue;
+        }
 
-          release_assert(false);
+        int32_t other = ruleIndices.at(&item.nonTerminal());
+        unionInto(followSets[other], suffixFirst);
+        if (suffixNullable && other != r)
+          followEdges[r].emplace_back(other);
+
+        if (nullable[other])
+        {
+          unionInto(suffixFirst, firstSets[other]);
+        }
+        else
+        {
+          suffixFirst = firstSets[other];
+          suffixNullable = false;
         }
-        tmp.insert(item);
       }
     }
   }
 
-  return retval;
-}
+  queueAll();
+  while (!worklist.empty())
+  {
+    int32_t r = worklist.back();
+    worklist.pop_back();
+    queued[r] = false;
 
-std::unordered_set<std::string> Grammar::follow(const std::string& _name) const
-{
-  std::unordered_set<std::string> _visited;
-  std::function<std::unordered_set<std::string>(const std::string&)> followInner = [&](const std::string& name) -> std::unordered_set<std::string>
+    for (int32_t other : followEdges[r])
+    {
+      if (unionInto(followSets[other], followSets[r]) && !queued[other])
+      {
+        queued[other] = true;
+        worklist.emplace_back(other);
+      }
+    }
+  }
+
+  // The per production FIRST lists keep the order the terminals are reached in, walking each production left
+  // to right, each terminal only the first time it's seen. A rule's list needs the lists of the rules it can start
+  // with, so build them in dependency order.
+  std::vector<std::vector<int32_t>> startUsers(ruleCount);
+  std::vector<int32_t> pendingStarts(ruleCount, 0);
+  for (int32_t r = 0; r < ruleCount; r++)
   {
-    if (_visited.contains(name))
-      return {};
+    for (const Production& production : ruleList[r]->productions)
+    {
+      for (const ProductionItem& item : production)
+      {
+        if (!item.isNonTerminal())
+          break;
 
-    _visited.insert(name);
+        int32_t other = ruleIndices.at(&item.nonTerminal());
+        startUsers[other].emplace_back(r);
+        pendingStarts[r]++;
 
-    std::unordered_set<std::string> follows;
-    const NonTerminal& nt = this->rules.at(name);
+        if (!nullable[other])
+          break;
+      }
+    }
+  }
 
-    for (const auto& pair : this->rules)
+  std::vector<std::vector<std::vector<int32_t>>> productionFirsts(ruleCount);
+  std::vector<std::vector<int32_t>> ruleFirsts(ruleCount);
+  std::vector<bool> firstsOverlap(ruleCount, false);
+  for (int32_t r = 0; r < ruleCount; r++)
+  {
+    if (pendingStarts[r] == 0)
+      worklist.emplace_back(r);
+  }
+
+  int32_t orderedCount = 0;
+  while (!worklist.empty())
+  {
+    int32_t r = worklist.back();
+    worklist.pop_back();
+    orderedCount++;
+
+    TerminalSet inRule(wordCount, 0);
+    for (const Production& production : ruleList[r]->productions)
     {
-      const NonTerminal& other_nt = pair.second;
-      for (const Production& production: other_nt.productions)
+      std::vector<int32_t>& list = productionFirsts[r].emplace_back();
+      TerminalSet inList(wordCount, 0);
+      for (const ProductionItem& item : production)
       {
-        for (int32_t i = 0; i < int32_t(production.size()); i++)
+        if (item == "Nil")
+          break;
+
+        if (item.isStr())
         {
-          if (production[i] == nt)
-          {
-            Production prod_temp(production.begin() + i, production.end());
-            while (true)
-            {
-              if (prod_temp.size() == 1)
-              {
-                if (prod_temp[0].isStr() || prod_temp[0] == nt || this->can_be_nil(prod_temp[0].nonTerminal().name))
-                {
-                  std::unordered_set<std::string> temp = followInner(other_nt.name);
-                  follows.insert(temp.begin(), temp.end());
-                }
-
-                break;
-              }
-              else
-              {
-                auto& next_symbol = prod_temp[1];
-                if (next_symbol.isNonTerminal())
-                {
-                  const NonTerminal& next_nt = next_symbol.nonTerminal();
-                  for (const std::vector<std::string>& x : this->first(next_nt.name))
-                  {
-                    for (const std::string& item : x)
-                      follows.insert(item);
-                  }
-
-                  if (!this->can_be_nil(next_nt.name))
-                    break;
-                }
-                else
-                {
-                  follows.insert(next_symbol.str());
-                  break;
-                }
-              }
-
-              prod_temp.erase(prod_temp.begin());
-            }
-          }
+          int32_t terminal = terminalIndices.at(item.str());
+          if (setBit(inList, terminal))
+            list.emplace_back(terminal);
+          break;
+        }
+
+        int32_t other = ruleIndices.at(&item.nonTerminal());
+        for (int32_t terminal : ruleFirsts[other])
+        {
+          if (setBit(inList, terminal))
+            list.emplace_back(terminal);
         }
+        if (!nullable[other])
+          break;
+      }
+
+      // already there from an earlier production means the next token can't decide between them
+      for (int32_t terminal : list)
+      {
+        if (setBit(inRule, terminal))
+          ruleFirsts[r].emplace_back(terminal);
+        else
+          firstsOverlap[r] = true;
       }
     }
 
-    follows.erase("Nil");
+    for (int32_t user : startUsers[r])
+    {
+      if (--pendingStarts[user] == 0)
+        worklist.emplace_back(user);
+    }
+  }
 
-    return follows;
-  };
+  if (orderedCount != ruleCount)
+    message_and_abort("Grammar is left recursive");
+
+  for (int32_t r = 0; r < ruleCount; r++)
+  {
+    RuleSets& sets = this->ruleSets[this->keys[r]];
+    sets.canBeNil = nullable[r];
+    sets.firstsOverlap = firstsOverlap[r];
+
+    for (const std::vector<int32_t>& list : productionFirsts[r])
+    {
+      std::vector<std::string>& names = sets.firsts.emplace_back();
+      for (int32_t terminal : list)
+        names.emplace_back(terminals[terminal]);
+    }
+
+    for (int32_t terminal = 0; terminal < int32_t(terminals.size()); terminal++)
+    {
+      if (followSets[r][terminal / 64] & (uint64_t(1) << (terminal % 64)))
+        sets.follows.insert(terminals[terminal]);
+    }
+  }
+}
+
+bool Grammar::can_be_nil(const std::string& name) const
+{
+  return this->ruleSets.at(name).canBeNil;
+}
+
+const std::vector<std::vector<std::string>>& Grammar::first(const std::string& name) const
+{
+  const RuleSets& sets = this->ruleSets.at(name);
 
-  return followInner(_name);
+  if (sets.firstsOverlap)
+  {
+    fprintf(stderr, "Duplicate first in %s\n", name.c_str());
+    for (const std::vector<std::string>& list: sets.firsts)
+    {
+      fprintf(stderr, "    ");
+      for (const std::string& item: list)
+        fprintf(stderr, "%s ", item.c_str());
+      fprintf(stderr, "\n");
+    }
+
+    release_assert(false);
+  }
+
+  return sets.firsts;
+}
+
+const std::unordered_set<std::string>& Grammar::follow(const std::string& name) const
+{
+  return this->ruleSets.at(name).follows;
 }
 
 std::string dumpProduction(const Production& production)
@@ -60,6 +60,10 @@ struct NonTerminal
   std::string codeInsertBefore;
   std::string codeInsertAfter;
   std::vector<Production> productions;
+
+  // Set by writing "loop" before the "=". A production that ends by calling the rule again then jumps back to the start
+  // instead, see generateParser(). Only safe if the rule's code inserts never redeclare its arguments.
+  bool loopsOnTailCall = false;
 };
 
 class Grammar
@@ -68,13 +72,24 @@ public:
   explicit Grammar(const std::string& str_table);
 
   bool can_be_nil(const std::string& name) const;
-  std::vector<std::vector<std::string>> first(const std::string& name) const;
-  std::unordered_set<std::string> follow(const std::string& _name) const;
+  const std::vector<std::vector<std::string>>& first(const std::string& name) const;
+  const std::unordered_set<std::string>& follow(const std::string& name) const;
 
   const std::unordered_map<std::string, NonTerminal>& getRules() const { return rules; }
   const std::vector<std::string>& getKeys() const { return keys; }
 
 private:
+  void computeSets();
+
+  struct RuleSets
+  {
+    bool canBeNil = false;
+    std::vector<std::vector<std::string>> firsts; // one list per production, in production order, without repeats
+    bool firstsOverlap = false; // two productions can start with the same terminal
+    std::unordered_set<std::string> follows;
+  };
+
   std::unordered_map<std::string, NonTerminal> rules;
   std::vector<std::string> keys; // keys into rules map, in the order they were declared in the source
+  std::unordered_map<std::string, RuleSets> ruleSets; // computed once in the constructor
 };
\ No newline at end of file
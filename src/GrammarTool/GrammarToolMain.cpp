@@ -12,10 +12,11 @@ const char* wlangGrammarStr = R"STR(
 
       rootNode->funcList->scope = makeNode<Scope>();
       pushScope(rootNode->funcList->scope);
-
+      uint32_t functionsStart = beginList<Func*>();
     }}
     FuncList<{rootNode->funcList}> $End
     {{
+      rootNode->funcList->functions = endList<Func*>(functionsStart);
       popScope();
       return rootNode;
     }};
@@ -24,15 +25,15 @@ const char* wlangGrammarStr = R"STR(
   FuncList <{void}> <{FuncList* funcList}>  =
     Func
     {{
-      funcList->functions.emplace_back(v0);
-      funcList->scope->functions.insert_or_assign(v0->name, Scope::Item<Func*>{.item = v0, .chunk = &ast});
+      pushToList(v0);
+      funcList->scope->functions.set(v0->name, Scope::Item<Func*>{.item = v0, .chunk = &ast});
     }}
     FuncList'<{funcList}>
   |
     ExternFuncDeclaration ";"
     {{
-      funcList->functions.emplace_back(v0);
-      funcList->scope->functions.insert_or_assign(v0->name, Scope::Item<Func*>{.item = v0, .chunk = &ast});
+      pushToList(v0);
+      funcList->scope->functions.set(v0->name, Scope::Item<Func*>{.item = v0, .chunk = &ast});
     }}
     FuncList'<{funcList}>
   |
@@ -46,37 +47,39 @@ const char* wlangGrammarStr = R"STR(
       type->typeClass = newClass;
       type->name = v0;
       funcList->classes.emplace_back(newClass);
-      funcList->scope->types.insert_or_assign(type->name, Scope::Item<Type*>{.item = type, .chunk = &ast});
+      funcList->scope->types.set(type->name, Scope::Item<Type*>{.item = type, .chunk = &ast});
+      uint32_t memberVariablesStart = beginList<VariableDeclaration*>();
     }}
-    "{" ClassMemberList<{newClass, funcList}> "}"
+    "{" ClassMemberList<{newClass}> "}"
+    {{ newClass->memberVariables = endList<VariableDeclaration*>(memberVariablesStart); }}
     FuncList'<{funcList}>
   |
     Nil
   ;
 
-  ClassMemberList <{void}> <{Class* newClass, FuncList* funcList}> =
+  ClassMemberList <{void}> <{Class* newClass}> loop =
     Type $Id
-    ClassMember<{v0, v1, newClass, funcList}>
-    ClassMemberList<{newClass, funcList}>
+    ClassMember<{v0, v1, newClass}>
+    ClassMemberList<{newClass}>
   |
     Nil
   ;
 
-  ClassMember <{void}> <{TypeRef& type, const std::string& id, Class* newClass, FuncList* funcList}> =
+  ClassMember <{void}> <{TypeRef& type, Symbol id, Class* newClass}> =
     TheRestOfADeclaration ";"
     {{
       VariableDeclaration* variableDeclaration = makeNode<VariableDeclaration>();
       variableDeclaration->type = type;
       variableDeclaration->name = id;
       variableDeclaration->initialiser = v0;
-      newClass->memberVariables.push_back(variableDeclaration);
-      newClass->memberScope->variables.emplace(variableDeclaration->name, Scope::Item<VariableDeclaration*>{.item = variableDeclaration, .chunk = &ast});
+      pushToList(variableDeclaration);
+      newClass->memberScope->variables.insert(variableDeclaration->name, Scope::Item<VariableDeclaration*>{.item = variableDeclaration, .chunk = &ast});
     }}
   |
     Func'<{type, id}>
     {{
-      funcList->functions.emplace_back(v0);
-      newClass->memberScope->functions.insert_or_assign(v0->name, Scope::Item<Func*>{.item = v0, .chunk = &ast});
+      pushToList(v0);
+      newClass->memberScope->functions.set(v0->name, Scope::Item<Func*>{.item = v0, .chunk = &ast});
       v0->memberClass = newClass;
     }}
   ;
@@ -90,11 +93,15 @@ const char* wlangGrammarStr = R"STR(
     {{
       Func* func = makeNode<Func>();
       func->returnType = v0;
-      func->name = std::move(v1);
+      func->name = v1;
       func->external = true;
+      uint32_t argsStart = beginList<VariableDeclaration*>();
     }}
     "(" ArgList<{func}> ")"
-    {{ return func; }}
+    {{
+      func->args = endList<VariableDeclaration*>(argsStart);
+      return func;
+    }}
   ;
 
 
@@ -104,78 +111,79 @@ const char* wlangGrammarStr = R"STR(
   ;
 
 
-  Func' <{Func*}> <{TypeRef& type, const std::string& id}> =
+  Func' <{Func*}> <{TypeRef& type, Symbol id}> =
     {{
       Func* func = makeNode<Func>();
       func->argsScope = makeNode<Scope>();
       func->returnType = type;
       func->name = id;
+      uint32_t argsStart = beginList<VariableDeclaration*>();
     }}
-    "(" ArgList<{func}> ")" Block
+    "(" ArgList<{func}> ")"
+    {{ func->args = endList<VariableDeclaration*>(argsStart); }}
+    Block
     {{
       func->funcBody = v0;
-      func->funcBody->scope->parent2 = func->argsScope;
+      get(v0)->scope->parent2 = func->argsScope;
       return func;
     }}
   ;
 
-  Block <{Block*}>
+  Block <{NodeRef<Block>}>
     {{
-      Block* block = makeNode<Block>();
+      NodeRef<Block> blockRef = addNode<Block>();
+      Block* block = get(blockRef);
       block->scope = makeNode<Scope>();
       block->scope->parent = getScope();
       pushScope(block->scope);
+      uint32_t statementsStart = beginList<NodeRef<Statement>>();
     }}
   =
-    "{" StatementList<{block}> "}"
+    "{" StatementList "}"
   ;
     {{
+      block->statements = endList<NodeRef<Statement>>(statementsStart);
       popScope();
-      return block;
+      return blockRef;
     }}
 
 
-  StatementList <{void}> <{Block* block}> =
-    Statement {{ block->statements.push_back(v0); }} StatementList'<{block}>
+  StatementList <{void}> =
+    Statement {{ pushToList(v0); }} StatementList'
   |
     Nil;
 
 
-  StatementList' <{void}> <{Block* block}> =
-    StatementList<{block}> | Nil;
+  StatementList' <{void}> =
+    StatementList | Nil;
 
 
-  Statement <{Statement*}>
-    {{ Statement* statement = makeNode<Statement>(); }}
-  =
+  Statement <{NodeRef<Statement>}>
     {{
-      ReturnStatement* returnStatement = makeNode<ReturnStatement>();
-      IntermediateExpression intermediate;
+      NodeRef<Statement> statementRef = addNode<Statement>();
+      Statement* statement = get(statementRef);
     }}
+  =
+    {{ IntermediateExpression intermediate; }}
     "return" Expression<{intermediate}> ";"
-    {{
-      returnStatement->retval = resolveIntermediateExpression(std::move(intermediate));
-      *statement = returnStatement;
-    }}
+    {{ *statement = addNode(ReturnStatement { .retval = resolveIntermediateExpression(std::move(intermediate)) }); }}
   |
-    {{ IfElseChain* ifElseChain = makeNode<IfElseChain>(); }}
-    "if" TheRestOfAnIf<{*ifElseChain}>
-    {{ *statement = ifElseChain; }}
+    {{ uint32_t itemsStart = beginList<NodeRef<IfElseChainItem>>(); }}
+    "if" TheRestOfAnIf
+    {{ *statement = addNode(IfElseChain { .items = endList<NodeRef<IfElseChainItem>>(itemsStart) }); }}
   |
     // declaration, or an expression that starts with $Id
     // This awkwardness exists because declarations (and assignments) are not expressions, which is a design choice
     // We basically need to copy paste the rules from Expression into Statement, so we can allow any expression as a statement
-    {{ SourceRange idSource = peek().source; }}
+    {{ SourceRange idSource = peekSource(); }}
     $Id StatementThatStartsWithId <{v0, idSource, statement}> ";"
   |
     // statement that starts with an expression that starts with integer
     $IntegerToken
     {{
-      Expression* partial = makeNode<Expression>();
-      partial->val = IntegerConstant { .val = v0.val, .size = v0.size };
-      partial->source = lastPopped().source;
+      SourceRange source = lastPoppedSource();
       IntermediateExpression intermediate;
-      intermediate.emplace_back(partial, partial->source);
+      intermediate.emplace_back(addNode(Expression { .val = IntegerConstant { .val = v0.val, .size = v0.size }, .source = source }), source);
     }}
     Expression'<{intermediate}> TheRestOfAStatement<{std::move(intermediate), statement}> ";"
   |
@@ -183,7 +191,7 @@ const char* wlangGrammarStr = R"STR(
     "!"
     {{
       IntermediateExpression intermediate;
-      intermediate.emplace_back(Op::Type::LogicalNot, lastPopped().source);
+      intermediate.emplace_back(Op::Type::LogicalNot, lastPoppedSource());
     }}
     Expression<{intermediate}> TheRestOfAStatement<{std::move(intermediate), statement}> ";"
   |
@@ -191,71 +199,58 @@ const char* wlangGrammarStr = R"STR(
     "-"
     {{
       IntermediateExpression intermediate;
-      intermediate.emplace_back(Op::Type::UnaryMinus, lastPopped().source);
+      intermediate.emplace_back(Op::Type::UnaryMinus, lastPoppedSource());
     }}
     Expression<{intermediate}> TheRestOfAStatement<{std::move(intermediate), statement}> ";"
   |
     // statement that starts with an expression that starts with false (again, why would you want this?)
     "false"
     {{
-      Expression* partial = makeNode<Expression>();
-      partial->val = false;
-      partial->source = lastPopped().source;
+      SourceRange source = lastPoppedSource();
       IntermediateExpression intermediate;
-      intermediate.emplace_back(partial, partial->source);
+      intermediate.emplace_back(addNode(Expression { .val = false, .source = source }), source);
     }}
     Expression'<{intermediate}> TheRestOfAStatement<{std::move(intermediate), statement}> ";"
   |
     // statement that starts with an expression that starts with true (again, why would you want this?)
     "true"
     {{
-      Expression* partial = makeNode<Expression>();
-      partial->val = true;
-      partial->source = lastPopped().source;
+      SourceRange source = lastPoppedSource();
       IntermediateExpression intermediate;
-      intermediate.emplace_back(partial, partial->source);
+      intermediate.emplace_back(addNode(Expression { .val = true, .source = source }), source);
     }}
     Expression'<{intermediate}> TheRestOfAStatement<{std::move(intermediate), statement}> ";"
   ;
-    {{ return statement; }}
+    {{ return statementRef; }}
 
 
-  TheRestOfAnIf <{void}> <{IfElseChain& chain}>
+  TheRestOfAnIf <{void}>
   =
     {{ IntermediateExpression intermediate; }}
     "(" Expression<{intermediate}> ")" Block
-    {{
-      IfElseChainItem* item = makeNode<IfElseChainItem>();
-      item->condition = resolveIntermediateExpression(std::move(intermediate));
-      item->block = v0;
-      chain.items.emplace_back(item);
-    }}
-    TheRestOfAnIf'<{chain}>
+    {{ pushToList(addNode(IfElseChainItem { .condition = resolveIntermediateExpression(std::move(intermediate)), .block = v0 })); }}
+    TheRestOfAnIf'
   ;
 
 
-  TheRestOfAnIf' <{void}> <{IfElseChain& chain}>
+  TheRestOfAnIf' <{void}>
   =
-    "else" TheRestOfAnIf''<{chain}>
+    "else" TheRestOfAnIf''
   |
     Nil
   ;
 
 
-  TheRestOfAnIf'' <{void}> <{IfElseChain& chain}>
+  TheRestOfAnIf'' <{void}>
   =
-    "if" TheRestOfAnIf<{chain}>
+    "if" TheRestOfAnIf
   |
     Block
-    {{
-      IfElseChainItem* item = makeNode<IfElseChainItem>();
-      item->block = v0;
-      chain.items.emplace_back(item);
-    }}
+    {{ pushToList(addNode(IfElseChainItem { .block = v0 })); }}
   ;
 
 
-  StatementThatStartsWithId <{void}> <{const std::string& id, SourceRange idSource, Statement* statement}> =
+  StatementThatStartsWithId <{void}> <{Symbol id, SourceRange idSource, Statement* statement}> =
     // declaration
     {{
       VariableDeclaration* variableDeclaration = makeNode<VariableDeclaration>();
@@ -264,24 +259,20 @@ const char* wlangGrammarStr = R"STR(
     Type'<{variableDeclaration->type}>
     $Id TheRestOfADeclaration
     {{
-      SourceRange declarationEnd = lastPopped().source;
+      SourceRange declarationEnd = lastPoppedSource();
 
       variableDeclaration->name = v0;
       variableDeclaration->initialiser = v1;
       variableDeclaration->source = SourceRange(idSource.start, declarationEnd.end);
 
-      getScope()->variables.insert_or_assign(variableDeclaration->name, Scope::Item<VariableDeclaration*>{.item = variableDeclaration, .chunk = &ast});
+      getScope()->variables.set(variableDeclaration->name, Scope::Item<VariableDeclaration*>{.item = variableDeclaration, .chunk = &ast});
       *statement = variableDeclaration;
     }}
   |
     // assign, or standalone expression that starts with id
     {{
-      Expression* partial = makeNode<Expression>();
-      partial->val = ScopeId(id);
-      partial->source = idSource;
-
       IntermediateExpression intermediate;
-      intermediate.emplace_back(partial, partial->source);
+      intermediate.emplace_back(addNode(Expression { .val = ScopeId(id), .source = idSource }), idSource);
     }}
     // The statement A*b is ambiguous - is it a multiplication or pointer declaration?
     // Here we resolve the ambiguity - it's a pointer declaration. We do this by using a special version
@@ -292,21 +283,17 @@ const char* wlangGrammarStr = R"STR(
     TheRestOfAStatement<{std::move(intermediate), statement}>
   |
     Nil
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = ScopeId(id);
-      *statement = expression;
-    }}
+    {{ *statement = addNode(Expression { .val = ScopeId(id) }); }}
   ;
 
 
-  TheRestOfADeclaration <{Expression*}> =
+  TheRestOfADeclaration <{NodeRef<Expression>}> =
     {{ IntermediateExpression intermediateExpression; }}
     "=" Expression<{intermediateExpression}>
     {{ return resolveIntermediateExpression(std::move(intermediateExpression)); }}
   |
     Nil
-    {{ return nullptr; }}
+    {{ return {}; }}
   ;
 
 
@@ -317,154 +304,161 @@ const char* wlangGrammarStr = R"STR(
     }}
     Expression<{intermediateR}>
     {{
-      Assignment* assignment = makeNode<Assignment>();
-      assignment->left = resolveIntermediateExpression(std::move(intermediateExpression));
-      assignment->right = resolveIntermediateExpression(std::move(intermediateR));
-      *statement = assignment;
+      *statement = addNode(Assignment
+      {
+        .left = resolveIntermediateExpression(std::move(intermediateExpression)),
+        .right = resolveIntermediateExpression(std::move(intermediateR)),
+      });
     }}
   |
     Nil
     {{ *statement = resolveIntermediateExpression(std::move(intermediateExpression)); }};
 
 
-  Expression <{void}> <{IntermediateExpression& result}>
-     {{ SourceRange source = peek().source; }}
+  // One operand, then the operators that follow it. Expression' loops over the operators rather than recursing, so an
+  // expression with thousands of operands doesn't use thousands of stack frames.
+  Expression <{void}> <{IntermediateExpression& result}> =
+    Operand<{result}>
+    {{ if (!v0) return; }}
+    Expression'<{result}>
+  ;
+
+
+  // Returns whether operators can follow, strings and null can't be operated on
+  Operand <{bool}> <{IntermediateExpression& result}>
+     {{ SourceRange source = peekSource(); }}
   =
     $Id
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = ScopeId(v0);
-      expression->source = source;
-      result.emplace_back(expression, expression->source);
-    }} Expression'<{result}>
+    {{ result.emplace_back(addNode(Expression { .val = ScopeId(v0), .source = source }), source); return true; }}
   |
     $IntegerToken
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = IntegerConstant { .val = v0.val, .size = v0.size };
-      expression->source = source;
-      result.emplace_back(expression, expression->source);
-    }} Expression'<{result}>
+    {{ result.emplace_back(addNode(Expression { .val = IntegerConstant { .val = v0.val, .size = v0.size }, .source = source }), source); return true; }}
   |
     $String
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = StringConstant { .val = v0 };
-      expression->source = source;
-      result.emplace_back(expression, expression->source);
-    }}
+    {{ result.emplace_back(addNode(Expression { .val = StringConstant { .val = v0 }, .source = source }), source); return false; }}
   |
     "false"
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = false;
-      expression->source = source;
-      result.emplace_back(expression, expression->source);
-    }} Expression'<{result}>
+    {{ result.emplace_back(addNode(Expression { .val = false, .source = source }), source); return true; }}
   |
     "true"
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = true;
-      expression->source = source;
-      result.emplace_back(expression, expression->source);
-    }} Expression'<{result}>
+    {{ result.emplace_back(addNode(Expression { .val = true, .source = source }), source); return true; }}
   |
     "null"
-    {{
-      Expression* expression = makeNode<Expression>();
-      expression->val = Null{};
-      expression->source = source;
-      result.emplace_back(expression, expression->source);
-    }}
+    {{ result.emplace_back(addNode(Expression { .val = Null{}, .source = source }), source); return false; }}
   |
     "!"
     {{
       result.emplace_back(Op::Type::LogicalNot, source);
-    }} Expression<{result}>
+    }} Operand<{result}>
+    {{ return v0; }}
   |
     "-"
     {{
       result.emplace_back(Op::Type::UnaryMinus, source);
-    }} Expression<{result}>
+    }} Operand<{result}>
+    {{ return v0; }}
   |
     "&"
     {{
       result.emplace_back(Op::Type::AddressOf, source);
-    }} Expression<{result}>
+    }} Operand<{result}>
+    {{ return v0; }}
   ;
 
 
-  Expression'NoMul <{void}> <{IntermediateExpression& result}> =
-    {{ result.emplace_back(Op::Type::CompareEqual, peek().source); }}
-    "==" Expression<{result}>
+  // Every operator except multiply, and the operand after it. Returns whether more operators can follow.
+  Operation <{bool}> <{IntermediateExpression& result}> =
+    {{ result.emplace_back(Op::Type::CompareEqual, peekSource()); }}
+    "==" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::CompareNotEqual, peek().source); }}
-    "!=" Expression<{result}>
+    {{ result.emplace_back(Op::Type::CompareNotEqual, peekSource()); }}
+    "!=" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::LogicalAnd, peek().source); }}
-    "&&" Expression<{result}>
+    {{ result.emplace_back(Op::Type::LogicalAnd, peekSource()); }}
+    "&&" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::LogicalOr, peek().source); }}
-    "||" Expression<{result}>
+    {{ result.emplace_back(Op::Type::LogicalOr, peekSource()); }}
+    "||" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::Add, peek().source); }}
-    "+" Expression<{result}>
+    {{ result.emplace_back(Op::Type::Add, peekSource()); }}
+    "+" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::Subtract, peek().source); }}
-    "-" Expression<{result}>
+    {{ result.emplace_back(Op::Type::Subtract, peekSource()); }}
+    "-" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::Divide, peek().source); }}
-    "/" Expression<{result}>
+    {{ result.emplace_back(Op::Type::Divide, peekSource()); }}
+    "/" Operand<{result}>
+    {{ return v0; }}
   |
-    {{ result.emplace_back(Op::Type::MemberAccess, peek().source); }}
-    "." Expression<{result}>
+    {{ result.emplace_back(Op::Type::MemberAccess, peekSource()); }}
+    "." Operand<{result}>
+    {{ return v0; }}
   |
     {{
-      result.emplace_back(Op::Type::Call, peek().source);
-      std::vector<Expression*> argList;
-      SourceRange openBracket = peek().source;
+      result.emplace_back(Op::Type::Call, peekSource());
+      uint32_t argsStart = beginList<NodeRef<Expression>>();
+      SourceRange openBracket = peekSource();
      }}
     "("
-     CallParamList<{argList}>
+     CallParamList
     {{
-      SourceRange closeBracket = peek().source;
-      result.emplace_back(std::move(argList), SourceRange(openBracket.start, closeBracket.end));
+      SourceRange closeBracket = peekSource();
+      result.emplace_back(endList<NodeRef<Expression>>(argsStart), SourceRange(openBracket.start, closeBracket.end));
     }}
     ")"
+    {{ return false; }}
   |
     {{
       IntermediateExpression intermediateExpression;
-      result.emplace_back(Op::Type::Subscript, peek().source);
-      SourceRange openBracket = peek().source;
+      result.emplace_back(Op::Type::Subscript, peekSource());
+      SourceRange openBracket = peekSource();
     }}
     "[" Expression<{intermediateExpression}> "]"
     {{
-      SourceRange closeBracket = peek().source;
-      Expression* index = resolveIntermediateExpression(std::move(intermediateExpression));
+      SourceRange closeBracket = peekSource();
+      NodeRef<Expression> index = resolveIntermediateExpression(std::move(intermediateExpression));
       result.emplace_back(index, SourceRange(openBracket.start, closeBracket.end));
+      return false;
     }}
+  ;
+
+
+  Expression'NoMul <{void}> <{IntermediateExpression& result}> =
+    Operation<{result}>
+    {{ if (!v0) return; }}
+    Expression'<{result}>
   |
     Nil;
 
 
-  Expression' <{void}> <{IntermediateExpression& result}> =
-    {{ result.emplace_back(Op::Type::Multiply, peek().source); }}
-    "*" Expression<{result}>
+  Expression' <{void}> <{IntermediateExpression& result}> loop =
+    {{ result.emplace_back(Op::Type::Multiply, peekSource()); }}
+    "*" Operand<{result}>
+    {{ if (!v0) return; }}
+    Expression'<{result}>
   |
-    Expression'NoMul<{result}>
-  ;
+    Operation<{result}>
+    {{ if (!v0) return; }}
+    Expression'<{result}>
+  |
+    Nil;
 
-  CallParamList <{void}> <{std::vector<Expression*>& argList}> =
+  CallParamList <{void}> =
     {{ IntermediateExpression intermediateExpression; }}
     Expression<{intermediateExpression}>
-    {{ argList.emplace_back(resolveIntermediateExpression(std::move(intermediateExpression))); }}
-    CallParamList'<{argList}>
+    {{ pushToList(resolveIntermediateExpression(std::move(intermediateExpression))); }}
+    CallParamList'
   |
     Nil;
 
-  CallParamList' <{void}> <{std::vector<Expression*>& argList}> =
-    "," CallParamList<{argList}>
+  CallParamList' <{void}> =
+    "," CallParamList
   |
     Nil;
 
@@ -475,7 +469,7 @@ const char* wlangGrammarStr = R"STR(
     {{ return retval; }}
   ;
 
-  Type' <{void}> <{TypeRef& typeRef}> =
+  Type' <{void}> <{TypeRef& typeRef}> loop =
     "*" {{ typeRef.pointerDepth++; }} Type'<{typeRef}>
   |
     Nil;
@@ -484,9 +478,9 @@ const char* wlangGrammarStr = R"STR(
   ArgList <{void}> <{Func* func}> =
     Arg
     {{
-      func->args.emplace_back(v0);
+      pushToList(v0);
       if (func->argsScope)
-        func->argsScope->variables.insert_or_assign(v0->name, Scope::Item<VariableDeclaration*>{.item = v0, .chunk = &ast});
+        func->argsScope->variables.set(v0->name, Scope::Item<VariableDeclaration*>{.item = v0, .chunk = &ast});
     }}
     ArgList'<{func}>
   |
@@ -550,7 +544,7 @@ void dumpFirstFollows(Grammar& grammar)
   {
     std::string line = "    " + name + " " + pad(name) + "= ";
 
-    std::unordered_set<std::string> follows = grammar.follow(name);
+    const std::unordered_set<std::string>& follows = grammar.follow(name);
     std::vector<std::string> sortedFollows(follows.begin(), follows.end());
     std::sort(sortedFollows.begin(), sortedFollows.end());
 
@@ -1,5 +1,6 @@
 #include "ParserGenerator.hpp"
 #include <string>
+#include <algorithm>
 #include "Grammar.hpp"
 #include "../Common/StringUtil.hpp"
 
@@ -117,9 +118,9 @@ ParserSource generateParser(const Grammar& grammar)
 
   std::unordered_map<std::string, std::string> idTokenMapping
   {
-    {"$Id", "std::string"},
+    {"$Id", "Symbol"},
     {"$IntegerToken", "IntegerToken"},
-    {"$String", "std::string"},
+    {"$String", "Symbol"},
   };
 
   auto sanitiseName = [](const std::string& ruleName)
@@ -133,10 +134,74 @@ ParserSource generateParser(const Grammar& grammar)
     return nameSanitised;
   };
 
+  // "IntermediateExpression& result, int x" -> "result,x". Only used on rules that opt in to looping, where the
+  // arguments are checked to be simple enough for this to work.
+  auto getArgumentNames = [](const std::string& arguments)
+  {
+    std::string names;
+    std::string name;
+    bool inName = false;
+    for (char c : arguments + ",")
+    {
+      bool isNameChar = Str::isAlphaNumeric(c) || c == '_';
+      if (isNameChar && !inName)
+        name.clear();
+      if (isNameChar)
+        name += c;
+      inName = isNameChar;
+
+      if (c == ',')
+      {
+        if (!names.empty())
+          names += ',';
+        names += name;
+      }
+    }
+    return names;
+  };
+
+  auto removeSpaces = [](const std::string& str)
+  {
+    std::string retval;
+    for (char c : str)
+    {
+      if (!Str::isSpace(c))
+        retval += c;
+    }
+    return retval;
+  };
+
+  // In a rule marked "loop", a production that ends by calling the rule again, with nothing left to do afterwards,
+  // jumps back to the start of the rule instead. This keeps the stack depth flat over long expressions, where each
+  // operand would otherwise cost a call. The grammar has to opt in, as whether the call really passes the same
+  // arguments can't be told reliably from the text, eg if a code insert declared a local with the same name.
+  auto endsWithTailCall = [&](const NonTerminal& rule, const Production& production)
+  {
+    const ProductionItem& item = production.back();
+    if (!rule.loopsOnTailCall || !item.isNonTerminal() || &item.nonTerminal() != &rule || !item.codeInsertAfter.empty())
+      return false;
+
+    if (removeSpaces(item.parameters) != getArgumentNames(rule.arguments))
+      message_and_abort(("loop rule " + rule.name + " calls itself with different arguments").c_str());
+    return true;
+  };
+
   for (const std::string& name: grammar.getKeys())
   {
     const NonTerminal& rule = grammar.getRules().at(name);
 
+    bool loops = rule.loopsOnTailCall;
+    if (loops)
+    {
+      // anything fancier than "Type& name" could confuse getArgumentNames()
+      release_assert(rule.arguments.find_first_of("<({[") == std::string::npos);
+      release_assert(rule.codeInsertAfter.empty() && (rule.returnType.empty() || rule.returnType == "void"));
+      release_assert(std::any_of(rule.productions.begin(), rule.productions.end(), [&](const Production& production)
+      {
+        return endsWithTailCall(rule, production);
+      }));
+    }
+
     // function declaration
     {
       std::string returnType = "void";
@@ -153,42 +218,55 @@ ParserSource generateParser(const Grammar& grammar)
     }
     appendSourceLine("{");
 
+    if (loops)
+    {
+      appendSourceLine("while (true)");
+      appendSourceLine("{");
+    }
+
     if (!rule.codeInsertBefore.empty())
     {
       handleSourceInsert(rule.codeInsertBefore);
       appendSourceLine("");
     }
 
-    std::vector<std::vector<std::string>> productionFirsts = grammar.first(name);
+    const std::vector<std::vector<std::string>>& productionFirsts = grammar.first(name);
+
+    // Each lookahead token predicts at most one production, so dispatch is a single switch on the next token.
+    // If the grammar is ambiguous, the earliest production claims the token, as the old if / else if chain did.
+    std::unordered_set<std::string> claimedTokens;
+
+    // The token stream always ends with an End token, and only parseRoot consumes it, so inside any rule there
+    // is at least one token left to peek at, and the token a case matched on can be popped without checking.
+    appendSourceLine("switch (peekUnchecked())");
+    appendSourceLine("{");
 
     for (int32_t i = 0; i < int32_t(rule.productions.size()); i++)
     {
       const Production& production = rule.productions[i];
       const std::vector<std::string>& firsts = productionFirsts[i];
 
-      std::string firstsCheck;
+      bool anyCase = false;
       for (const std::string& item: firsts)
       {
-        if (item == "Nil")
+        if (item == "Nil" || !claimedTokens.insert(item).second)
           continue;
-        firstsCheck += "peekCheck(TT::" + tokenTypeMapping.at(item) + ") || ";
+        appendSourceLine("case TT::" + tokenTypeMapping.at(item) + ":");
+        anyCase = true;
       }
 
-      if (firstsCheck.empty())
+      if (!anyCase)
         continue;
 
-      firstsCheck.resize(firstsCheck.size() - 4);
-
-      if (i > 0)
-        appendSourceLine("else if (" + firstsCheck + ")");
-      else
-        appendSourceLine("if (" + firstsCheck + ")");
       appendSourceLine("{");
 
+      bool tailCall = endsWithTailCall(rule, production);
+
       int32_t variableIndex = 0;
       for (int32_t productionIndex = 0; productionIndex < int32_t(production.size()); productionIndex++)
       {
         const ProductionItem& item = production[productionIndex];
+        bool isTailCall = tailCall && productionIndex == int32_t(production.size()) - 1;
 
         if (item == "Nil")
             continue;
@@ -216,13 +294,17 @@ ParserSource generateParser(const Grammar& grammar)
           }
           else if (productionIndex == 0)
           {
-            appendSourceLine("pop();");
+            appendSourceLine("popUnchecked();");
           }
           else
           {
             appendSourceLine("release_assert(popCheck(TT::" + tokenTypeMapping.at(item.str()) + "));");
           }
         }
+        else if (isTailCall)
+        {
+          appendSourceLine("continue; // tail call to parse" + sanitiseName(name));
+        }
         else
         {
           std::string callLine;
@@ -249,14 +331,31 @@ ParserSource generateParser(const Grammar& grammar)
         }
       }
 
+      // unreachable if the inserted code returns, but that can't be told reliably from its text
+      if (!tailCall)
+        appendSourceLine("break;");
       appendSourceLine("}");
     }
 
-    appendSourceLine("else");
-    appendSourceLine("{");
-
     if (grammar.can_be_nil(name))
     {
+      // sorted so the generated source doesn't depend on hash order
+      const std::unordered_set<std::string>& followSet = grammar.follow(name);
+      std::vector<std::string> follows(followSet.begin(), followSet.end());
+      std::sort(follows.begin(), follows.end());
+
+      bool anyCase = false;
+      for (const std::string& item: follows)
+      {
+        if (!claimedTokens.insert(item).second)
+          continue;
+        appendSourceLine("case TT::" + tokenTypeMapping.at(item) + ":");
+        anyCase = true;
+      }
+      release_assert(anyCase);
+
+      appendSourceLine("{");
+
       // if Nil is direct, then insert code attached to it (if any)
       const Production& lastProduction = rule.productions[rule.productions.size() - 1];
       bool lastProductionIsNil = lastProduction.size() == 1 && lastProduction[0] == "Nil";
@@ -264,26 +363,24 @@ ParserSource generateParser(const Grammar& grammar)
       if (lastProductionIsNil && !lastProduction[0].codeInsertBefore.empty())
         handleSourceInsert(lastProduction[0].codeInsertBefore);
 
-      std::unordered_set<std::string> follows = grammar.follow(name);
-
-      std::string followsCheck;
-      for (const std::string& item: follows)
-        followsCheck += "peekCheck(TT::" + tokenTypeMapping.at(item) + ") || ";
-
-      release_assert(!followsCheck.empty());
-      followsCheck.resize(followsCheck.size() - 4);
-
-      appendSourceLine("release_assert(" + followsCheck + ");");
-
       if (lastProductionIsNil && !lastProduction[0].codeInsertAfter.empty())
         handleSourceInsert(lastProduction[0].codeInsertAfter);
-    }
-    else
-    {
-      appendSourceLine("message_and_abort(\"fail!\");");
+
+      appendSourceLine("break;");
+      appendSourceLine("}");
     }
 
+    appendSourceLine("default:");
+    appendSourceLine("{");
+    appendSourceLine("message_and_abort(\"fail!\");");
     appendSourceLine("}");
+    appendSourceLine("}");
+
+    if (loops)
+    {
+      appendSourceLine("break;");
+      appendSourceLine("}");
+    }
 
     if (!rule.codeInsertAfter.empty())
     {
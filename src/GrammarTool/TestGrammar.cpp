@@ -1,4 +1,5 @@
 #include "Grammar.hpp"
+#include "ParserGenerator.hpp"
 #include "../Common/Assert.hpp"
 
 void test_can_be_nil()
@@ -106,6 +107,17 @@ void test_first()
   )STR");
 
   release_assert((rules.first("Root") == vvs{{"\"1\"", "\"X\""}, {"\"2\"", "\"Y\""}}));
+
+  // B's terminals are reached both through A and directly, but only listed once
+  rules = Grammar(R"STR(
+      Root = Y $End;
+      Y = A B "z";
+      A = B | Nil;
+      B = "1" | "2";
+  )STR");
+
+  release_assert((rules.first("A") == vvs{{"\"1\"", "\"2\""}, {}}));
+  release_assert((rules.first("Y") == vvs{{"\"1\"", "\"2\""}}));
 }
 
 using ss = std::unordered_set<std::string>;
@@ -249,12 +261,100 @@ void testRuleParameters()
   }
 }
 
+// A long chain of nullable rules, with enough terminals to need several words per set:
+//   Root = S0 $End;
+//   Si = Ni Si+1; (the last one is just Ni)
+//   Ni = "ti" | Nil;
+void test_large_grammar()
+{
+  constexpr int32_t count = 1000;
+
+  auto terminal = [](int32_t i) { return "\"t" + std::to_string(i) + "\""; };
+
+  std::string source = "Root = S0 $End;\n";
+  for (int32_t i = 0; i < count; i++)
+  {
+    std::string n = std::to_string(i);
+    if (i + 1 < count)
+      source += "S" + n + " = N" + n + " S" + std::to_string(i + 1) + ";\n";
+    else
+      source += "S" + n + " = N" + n + ";\n";
+    source += "N" + n + " = " + terminal(i) + " | Nil;\n";
+  }
+
+  Grammar rules(source);
+
+  std::vector<std::string> allTerminals;
+  for (int32_t i = 0; i < count; i++)
+    allTerminals.emplace_back(terminal(i));
+
+  release_assert(!rules.can_be_nil("Root"));
+  std::vector<std::string> rootFirsts = allTerminals;
+  rootFirsts.emplace_back("$End");
+  release_assert(rules.first("Root") == vvs{rootFirsts});
+  release_assert((rules.follow("Root") == ss{}));
+
+  for (int32_t i = 0; i < count; i++)
+  {
+    std::string n = std::to_string(i);
+    release_assert(rules.can_be_nil("S" + n));
+    release_assert(rules.can_be_nil("N" + n));
+
+    release_assert(rules.first("S" + n) == vvs{std::vector<std::string>(allTerminals.begin() + i, allTerminals.end())});
+    release_assert((rules.first("N" + n) == vvs{{terminal(i)}, {}}));
+
+    release_assert((rules.follow("S" + n) == ss{"$End"}));
+
+    ss nFollows(allTerminals.begin() + i + 1, allTerminals.end());
+    nFollows.insert("$End");
+    release_assert(rules.follow("N" + n) == nFollows);
+  }
+}
+
+void testTailCallLoop()
+{
+  Grammar rules(R"STR(
+    Root = $Id List<{list, 1}> List'<{list}> Map<{m}> Shadow<{x}> $End;
+    List<{void}><{SymbolList& list, int x}> loop = $Id {{ list.push_back(v0); }} List<{list,x}> | Nil;
+    List'<{void}><{std::vector<Symbol>& list}> = "," List'<{list}> {{ list.clear(); }} | "+" List<{list, 2}> | Nil;
+    Map<{void}><{std::map<int, int>& m}> = "*" Map<{int, m}> | Nil;
+    Shadow<{void}><{int x}> = "-" {{ int x = 2; }} Shadow<{x}> | Nil;
+  )STR");
+
+  release_assert(rules.getRules().at("List").loopsOnTailCall);
+  release_assert(!rules.getRules().at("List'").loopsOnTailCall);
+
+  std::string source = generateParser(rules).implementationSource;
+  auto getFunction = [&](std::string_view name)
+  {
+    size_t start = source.find(name);
+    release_assert(start != std::string::npos);
+    return source.substr(start, source.find("\n}\n", start) - start);
+  };
+
+  // marked loop, and calls itself last with the same arguments
+  std::string list = getFunction("void Parser::parseList(");
+  release_assert(list.find("while (true)") != std::string::npos);
+  release_assert(list.find("continue; // tail call to parseList") != std::string::npos);
+  release_assert(list.find("parseList(list") == std::string::npos);
+
+  // Not marked, so they recurse. These all look like they pass their arguments on unchanged, but only List'
+  // does: Map's argument names can't be picked out of its template type, and Shadow passes a local, not its argument.
+  for (std::string_view name : {"void Parser::parseListP(", "void Parser::parseMap(", "void Parser::parseShadow("})
+    release_assert(getFunction(name).find("while (true)") == std::string::npos);
+  release_assert(getFunction("void Parser::parseListP(").find("parseListP(list);") != std::string::npos);
+  release_assert(getFunction("void Parser::parseMap(").find("parseMap(int, m);") != std::string::npos);
+  release_assert(getFunction("void Parser::parseShadow(").find("parseShadow(x);") != std::string::npos);
+}
+
 void test()
 {
+  testTailCallLoop();
   testRuleParameters();
   testCodeInsert();
   testReturnType();
   test_can_be_nil();
   test_first();
   test_follow();
+  test_large_grammar();
 }
\ No newline at end of file
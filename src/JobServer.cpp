@@ -0,0 +1,201 @@
+#include "JobServer.hpp"
+#include "Common/Assert.hpp"
+#include "Common/StringUtil.hpp"
+
+#ifndef WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "UnixWrap.hpp"
+#endif
+
+JobServer::~JobServer()
+{
+  while (!this->tokens.empty())
+    this->release();
+
+#ifndef WIN32
+  if (this->readFd != -1)
+    w_close(this->readFd);
+  if (this->ownsWriteFd)
+    w_close(this->writeFd);
+#endif
+}
+
+#ifdef WIN32
+bool JobServer::connectToMake(std::string_view, std::string&)
+{
+  // make on windows uses a named semaphore instead, which we don't support yet
+  return false;
+}
+
+bool JobServer::open(std::string_view, std::string&)
+{
+  return false;
+}
+#else
+static bool parseFd(std::string_view string, int& fd)
+{
+  if (string.empty() || string.size() > 9 || !Str::isNumeric(string))
+    return false;
+  fd = std::stoi(std::string(string));
+  return true;
+}
+
+bool JobServer::connectToMake(std::string_view makeFlags, std::string& error)
+{
+  release_assert(!this->isConnectedToMake());
+
+  // --jobserver-fds is what make before 4.2 called it. If there's more than one, the last one wins.
+  std::string_view auth;
+  while (!makeFlags.empty())
+  {
+    size_t end = makeFlags.find(' ');
+    std::string_view word = makeFlags.substr(0, end);
+    makeFlags = end == std::string_view::npos ? std::string_view() : makeFlags.substr(end + 1);
+
+    for (std::string_view prefix : {"--jobserver-auth=", "--jobserver-fds="})
+    {
+      if (word.starts_with(prefix))
+        auth = word.substr(prefix.size());
+    }
+  }
+
+  if (auth.empty())
+    return false;
+
+  if (!this->open(auth, error))
+  {
+    this->localSlotCount = 1;
+    return false;
+  }
+  return true;
+}
+
+bool JobServer::open(std::string_view auth, std::string& error)
+{
+  // We need to read tokens without blocking, so we can keep collecting output from the compilers we already have
+  // running while we wait.
+  if (auth.starts_with("fifo:"))
+  {
+    std::string path(auth.substr(5));
+    this->readFd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (this->readFd == -1)
+    {
+      error = "failed to open jobserver fifo " + path;
+      return false;
+    }
+
+    this->writeFd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (this->writeFd == -1)
+    {
+      w_close(this->readFd);
+      this->readFd = -1;
+      error = "failed to open jobserver fifo " + path;
+      return false;
+    }
+    this->ownsWriteFd = true;
+    return true;
+  }
+
+  size_t comma = auth.find(',');
+  int inheritedReadFd = -1;
+  int inheritedWriteFd = -1;
+  if (comma == std::string_view::npos || !parseFd(auth.substr(0, comma), inheritedReadFd) || !parseFd(auth.substr(comma + 1), inheritedWriteFd))
+  {
+    error = "unrecognised jobserver " + std::string(auth);
+    return false;
+  }
+
+  // make closes the pipe for commands it doesn't think are recursive makes
+  if (fcntl(inheritedReadFd, F_GETFD) == -1 || fcntl(inheritedWriteFd, F_GETFD) == -1)
+  {
+    error = "jobserver pipe is closed, prefix the rule that runs wlang with '+' to share make's jobs";
+    return false;
+  }
+
+#ifdef __linux__
+  // The pipe is shared with make and every other client, so we can't set O_NONBLOCK on it without breaking them.
+  // Opening it again gives us our own description of the same pipe that we can.
+  std::string path = "/proc/self/fd/" + std::to_string(inheritedReadFd);
+  this->readFd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (this->readFd == -1)
+  {
+    error = "failed to reopen jobserver pipe";
+    return false;
+  }
+
+  this->writeFd = inheritedWriteFd;
+  this->ownsWriteFd = false;
+  return true;
+#else
+  error = "jobserver pipes are only supported on linux, use make 4.4's fifo jobserver (--jobserver-style=fifo)";
+  return false;
+#endif
+}
+#endif
+
+bool JobServer::tryAcquire()
+{
+  if (!this->implicitSlotInUse)
+  {
+    this->implicitSlotInUse = true;
+    return true;
+  }
+
+  if (!this->isConnectedToMake())
+  {
+    if (this->localSlotsInUse + 1 >= this->localSlotCount)
+      return false;
+    this->localSlotsInUse++;
+    return true;
+  }
+
+#ifdef WIN32
+  message_and_abort("unreachable");
+#else
+  if (this->readAtEndOfFile)
+    return false;
+
+  char token = 0;
+  ssize_t bytesRead = w_read(this->readFd, &token, 1);
+  if (bytesRead == 1)
+  {
+    this->tokens.emplace_back(token);
+    return true;
+  }
+
+  // From now on we only have the implicit slot
+  if (bytesRead == 0)
+  {
+    this->readAtEndOfFile = true;
+    return false;
+  }
+
+  // someone else may have got to the token first
+  release_assert(errno == EAGAIN || errno == EWOULDBLOCK);
+  return false;
+#endif
+}
+
+void JobServer::release()
+{
+  if (!this->tokens.empty())
+  {
+#ifndef WIN32
+    char token = this->tokens.back();
+    release_assert(w_write(this->writeFd, &token, 1) == 1);
+#endif
+    this->tokens.pop_back();
+    return;
+  }
+
+  if (this->localSlotsInUse > 0)
+  {
+    this->localSlotsInUse--;
+    return;
+  }
+
+  release_assert(this->implicitSlotInUse);
+  this->implicitSlotInUse = false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Hands out slots for running child processes. On its own it allows up to localSlotCount at once, but when we're run
+// from "make -jN" it can instead share make's jobserver, so the whole build stays at N jobs, not N for make plus N for
+// us. See https://www.gnu.org/software/make/manual/html_node/POSIX-Jobserver.html
+class JobServer
+{
+public:
+  explicit JobServer(int32_t localSlotCount) : localSlotCount(localSlotCount) {}
+  JobServer(const JobServer&) = delete;
+  JobServer& operator=(const JobServer&) = delete;
+  ~JobServer(); // returns any tokens we're still holding
+
+  // Joins the jobserver described by a MAKEFLAGS value, if it has one. If there is one but we can't use it, returns
+  // false with error set, and like make we fall back to running one job at a time.
+  [[nodiscard]] bool connectToMake(std::string_view makeFlags, std::string& error);
+  bool isConnectedToMake() const { return this->readFd != -1; }
+
+  // Never blocks. Every successful tryAcquire() must be paired with a release().
+  [[nodiscard]] bool tryAcquire();
+  void release();
+
+  // When connected to make, this becomes readable when there might be a token to acquire. -1 otherwise, when we can
+  // only get a slot by releasing one of our own.
+  int getWaitFd() const { return this->readAtEndOfFile ? -1 : this->readFd; }
+
+private:
+  bool open(std::string_view auth, std::string& error);
+
+private:
+  int32_t localSlotCount = 1;
+  int32_t localSlotsInUse = 0;
+
+  // Make counts us as one job already, so we always get one slot without needing a token
+  bool implicitSlotInUse = false;
+
+  int readFd = -1;
+  int writeFd = -1;
+  bool ownsWriteFd = false;
+  bool readAtEndOfFile = false; // make has closed its end, so no more tokens will come, and polling would never block
+  std::vector<char> tokens; // make wants back exactly the bytes it gave us
+};
@@ -0,0 +1,24 @@
+#include "LineTable.hpp"
+#include "ScanKernels.hpp"
+#include <algorithm>
+
+LineTable::LineTable(std::string_view source)
+{
+  const char* begin = source.data();
+  const char* end = begin + source.size();
+
+  this->lineStarts.push_back(0);
+  for (const char* p = Scan::findNewline(begin, end); p != end; p = Scan::findNewline(p + 1, end))
+    this->lineStarts.push_back(uint32_t(p + 1 - begin));
+}
+
+LineTable::LineColumn LineTable::get(SourceLocation location) const
+{
+  // the last line that starts at or before location
+  auto it = std::upper_bound(this->lineStarts.begin(), this->lineStarts.end(), location) - 1;
+  return LineColumn
+  {
+    .line = int32_t(it - this->lineStarts.begin()) + 1,
+    .column = int32_t(location - *it) + 1,
+  };
+}
\ No newline at end of file
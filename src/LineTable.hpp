@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <string_view>
+#include "Tokeniser.hpp"
+
+// Maps source offsets back to line and column. Built in one pass over the source, only once something needs reporting.
+class LineTable
+{
+public:
+  explicit LineTable(std::string_view source);
+
+  struct LineColumn
+  {
+    int32_t line = 0; // both 1-based
+    int32_t column = 0;
+  };
+
+  LineColumn get(SourceLocation location) const;
+
+private:
+  std::vector<uint32_t> lineStarts;
+};
\ No newline at end of file
@@ -5,14 +5,14 @@
 MergedAst::MergedAst()
 {
   for (const auto& pair : BuiltinTypes::inst.typeMap)
-    this->linkScope.types.insert_or_assign(pair.first, Scope::Item<Type*>{.item = pair.second, .chunk = nullptr});
+    this->linkScope.types.set(pair.first, Scope::Item<Type*>{.item = pair.second, .chunk = nullptr});
 }
 
-AstChunk* MergedAst::create(std::string_view path)
+AstChunk* MergedAst::add(std::unique_ptr<AstChunk> chunk)
 {
-  auto it = this->chunks.find(path);
+  auto it = this->chunks.find(chunk->path);
   release_assert(it == this->chunks.end());
-  return this->chunks.emplace_hint(it, path, new AstChunk())->second.get();
+  return this->chunks.emplace_hint(it, chunk->path, std::move(chunk))->second.get();
 }
 
 void MergedAst::link(AstChunk* chunk)
@@ -20,44 +20,35 @@ void MergedAst::link(AstChunk* chunk)
   Scope* chunkScope = chunk->root->funcList->scope;
   release_assert(!chunkScope->parent);
 
-  for (auto& item : chunkScope->types)
-    this->linkScope.types.insert(item);
+  chunkScope->types.forEach([&](Symbol name, const Scope::Item<Type*>& item) { this->linkScope.types.insert(name, item); });
   chunkScope->types.clear();
 
-  for (const auto& item : chunkScope->variables)
-    this->linkScope.variables.insert(item);
+  chunkScope->variables.forEach([&](Symbol name, const Scope::Item<VariableDeclaration*>& item) { this->linkScope.variables.insert(name, item); });
   chunkScope->variables.clear();
 
-  for (const auto& item : chunkScope->functions)
-    this->linkScope.functions.insert(item);
+  chunkScope->functions.forEach([&](Symbol name, const Scope::Item<Func*>& item) { this->linkScope.functions.insert(name, item); });
   chunkScope->functions.clear();
 
   for (Func* function : chunk->root->funcList->functions)
   {
-    std::string name = function->name;
+    Symbol name = function->name;
 
     if (function->memberClass)
-      name = function->memberClass->type->name + "_" + function->name;
+      name = Symbol(std::string(function->memberClass->type->name.str()) + "_" + std::string(function->name.str()));
 
     release_assert(!this->usedMangledNames.contains(name));
 
     this->usedMangledNames.insert(name);
-    function->mangledName = std::move(name);
+    function->mangledName = name;
   }
 
   chunkScope->parent = &this->linkScope;
 }
 
 template<typename T>
-static void removeChunkPart(AstChunk* chunk, HashMap<Scope::Item<T*>> map)
+static void removeChunkPart(AstChunk* chunk, ScopeTable<Scope::Item<T*>>& table)
 {
-  for (auto it = map.begin(); it != map.end();)
-  {
-    if (it->second.chunk == chunk)
-      it = map.erase(it);
-    else
-      ++it;
-  }
+  table.removeIf([&](Symbol, const Scope::Item<T*>& item) { return item.chunk == chunk; });
 }
 
 void MergedAst::tryRemoveChunk(std::string_view path)
@@ -70,7 +61,7 @@ void MergedAst::tryRemoveChunk(std::string_view path)
 
   removeChunkPart(chunk, this->linkScope.types);
   removeChunkPart(chunk, this->linkScope.variables);
-  removeChunkPart(chunk, this->linkScope.variables);
+  removeChunkPart(chunk, this->linkScope.functions);
 
   for (Func* function : chunk->root->funcList->functions)
     this->usedMangledNames.erase(function->mangledName);
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include "AstChunk.hpp"
+#include "HashMap.hpp"
 
 class MergedAst
 {
@@ -11,7 +12,7 @@ public:
   MergedAst& operator=(const MergedAst&) = delete;
   MergedAst& operator=(MergedAst&&) = delete;
 
-  AstChunk* create(std::string_view path);
+  AstChunk* add(std::unique_ptr<AstChunk> chunk); // chunks can be built on other threads, but must be added from one
   void link(AstChunk* chunk);
   void tryRemoveChunk(std::string_view path);
 
@@ -36,5 +37,5 @@ private:
 
 public:
   Scope linkScope;
-  HashSet usedMangledNames;
+  SymbolSet usedMangledNames;
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "Common/Assert.hpp"
+
+// A 32 bit handle to a node in one of an AstChunk's NodeArrays. Index 0 means null, so a default constructed ref is
+// empty, like a null pointer. Refs only mean something together with the chunk that made them.
+template<typename T> struct NodeRef
+{
+  uint32_t index = 0;
+
+  explicit operator bool() const { return this->index != 0; }
+  bool operator==(const NodeRef& other) const = default;
+};
+
+// Every node of one kind in a chunk, numbered in order of creation. Nodes are stored in segments, each twice the size
+// of the one before, so adding a node never moves the existing ones and pointers to them stay valid while parsing.
+template<typename T> class NodeArray
+{
+public:
+  NodeArray() = default;
+  NodeArray(const NodeArray&) = delete;
+  NodeArray(NodeArray&& other) noexcept : segments(std::move(other.segments)), count(std::exchange(other.count, 0)) {}
+  ~NodeArray() { this->destroyAll(); }
+  NodeArray& operator=(const NodeArray&) = delete;
+  NodeArray& operator=(NodeArray&& other) noexcept
+  {
+    if (this != &other)
+    {
+      this->destroyAll();
+      this->segments = std::move(other.segments);
+      this->count = std::exchange(other.count, 0);
+    }
+    return *this;
+  }
+
+  NodeRef<T> add(T&& node)
+  {
+    release_assert(this->count < UINT32_MAX - 1);
+    uint32_t position = this->count;
+
+    uint32_t segment = getSegment(position);
+    if (segment == this->segments.size())
+      this->segments.push_back(std::allocator<T>().allocate(getSegmentSize(segment)));
+
+    new (this->segments[segment] + (position - getSegmentStart(segment))) T(std::move(node));
+    this->count++;
+    return NodeRef<T> { .index = position + 1 };
+  }
+
+  // Null refs give back nullptr
+  T* get(NodeRef<T> ref)
+  {
+    if (!ref)
+      return nullptr;
+
+    debug_assert(ref.index <= this->count);
+    uint32_t position = ref.index - 1;
+    uint32_t segment = getSegment(position);
+    return this->segments[segment] + (position - getSegmentStart(segment));
+  }
+
+  const T* get(NodeRef<T> ref) const { return const_cast<NodeArray*>(this)->get(ref); }
+
+  uint32_t size() const { return this->count; }
+
+private:
+  static constexpr uint32_t firstSegmentSize = 64;
+
+  static uint32_t getSegment(uint32_t position) { return uint32_t(std::bit_width(position / firstSegmentSize + 1)) - 1; }
+  static uint32_t getSegmentStart(uint32_t segment) { return firstSegmentSize * ((1u << segment) - 1); }
+  static size_t getSegmentSize(uint32_t segment) { return size_t(firstSegmentSize) << segment; }
+
+  void destroyAll()
+  {
+    for (uint32_t segment = 0; segment < this->segments.size(); segment++)
+    {
+      uint32_t start = getSegmentStart(segment);
+      uint32_t used = std::min<uint32_t>(this->count - start, uint32_t(getSegmentSize(segment)));
+      std::destroy_n(this->segments[segment], used);
+      std::allocator<T>().deallocate(this->segments[segment], getSegmentSize(segment));
+    }
+    this->segments.clear();
+    this->count = 0;
+  }
+
+  std::vector<T*> segments;
+  uint32_t count = 0;
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "Parallel.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+int32_t getHardwareThreadCount()
+{
+  return std::max(int32_t(std::thread::hardware_concurrency()), 1);
+}
+
+bool parallelFor(int32_t jobCount, int32_t threadCount, const std::function<bool(int32_t)>& job)
+{
+  std::atomic_int32_t nextJob = 0;
+  std::atomic_bool failed = false;
+
+  auto worker = [&]()
+  {
+    while (!failed)
+    {
+      int32_t index = nextJob++;
+      if (index >= jobCount)
+        return;
+
+      if (!job(index))
+        failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  int32_t extraThreads = std::min(threadCount, jobCount) - 1;
+  for (int32_t i = 0; i < extraThreads; i++)
+    threads.emplace_back(worker);
+
+  worker();
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return !failed;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+int32_t getHardwareThreadCount();
+
+// Calls job(i) for every i in [0, jobCount), spread over up to threadCount threads (the calling thread included).
+// Once any job returns false, no new jobs are started. Returns false if any job failed.
+[[nodiscard]] bool parallelFor(int32_t jobCount, int32_t threadCount, const std::function<bool(int32_t)>& job);
@@ -1,5 +1,6 @@
 #include "Parser.hpp"
 #include <optional>
+#include <tuple>
 #include <unordered_set>
 #include "Common/Assert.hpp"
 #include "BuiltinTypes.hpp"
@@ -8,18 +9,17 @@
 class Parser
 {
 public:
-  Parser(AstChunk& ast, const Token* tokens, size_t size)
+  Parser(AstChunk& ast, std::string_view source)
     : ast(ast)
-    , next(tokens)
-    , remaining(size)
+    , reader(source)
   {}
 
   struct IntermediateExpressionItem
   {
     #define FOR_EACH_TAGGED_UNION_TYPE(XX) \
-      XX(expression, Expression, Expression*) \
+      XX(expression, Expression, NodeRef<Expression>) \
       XX(op, Op, Op::Type) \
-      XX(callArgs, CallArgs, std::vector<Expression*>)
+      XX(callArgs, CallArgs, ArenaList<NodeRef<Expression>>)
 
     #define CLASS_NAME Val
     #include "CreateTaggedUnion.hpp"
@@ -31,48 +31,75 @@ public:
   };
 
   using IntermediateExpression = std::vector<IntermediateExpressionItem>;
-  Expression* resolveIntermediateExpression(IntermediateExpression&& intermediate);
-  std::string parseId();
+  NodeRef<Expression> resolveIntermediateExpression(IntermediateExpression&& intermediate);
+  NodeRef<Expression> resolveBinary(IntermediateExpression& intermediate, int32_t& i, int32_t minimumPrecedence);
+  NodeRef<Expression> resolveUnary(IntermediateExpression& intermediate, int32_t& i);
+
+  template<typename Args> NodeRef<Expression> makeOpExpression(Op::Type type, Args args, SourceRange source)
+  {
+    NodeRef<Op> op = addNode(Op { .type = type, .args = std::move(args) });
+    return addNode(Expression { .val = op, .source = source });
+  }
+
+  Symbol parseId();
   IntegerToken parseIntegerToken();
-  std::string parseString();
+  Symbol parseString();
 
   #include "ParserRulesDeclarations.inl"
 
-  const Token& peek()
+  TokenType peek()
+  {
+    release_assert(!empty());
+    return this->reader.peek().type;
+  }
+
+  // The reader returns End forever once the input is used up, and only the root rule pops it, so the generated
+  // rules can skip the checks while it's still there
+  TokenType peekUnchecked()
+  {
+    debug_assert(!empty());
+    return this->reader.peek().type;
+  }
+
+  bool peekCheck(TokenType type)
   {
-    release_assert(remaining > 0);
-    return *next;
+    return peek() == type;
   }
 
-  bool peekCheck(Token::Type type)
+  SourceRange peekSource()
   {
-    return peek().type == type;
+    release_assert(!empty());
+    return this->reader.peek().source;
   }
 
   const Token& pop()
   {
     release_assert(!empty());
-    const Token* retval = next;
-    next++;
-    remaining--;
-    popped = retval;
-    return *retval;
+    popUnchecked();
+    return this->popped;
   }
 
-  const Token& lastPopped()
+  void popUnchecked()
   {
-    release_assert(this->popped);
-    return *this->popped;
+    debug_assert(!empty());
+    this->popped = this->reader.pop();
+    this->anyPopped = true;
   }
 
-  bool popCheck(Token::Type type)
+  SourceRange lastPoppedSource()
+  {
+    release_assert(this->anyPopped);
+    return this->popped.source;
+  }
+
+  bool popCheck(TokenType type)
   {
     return pop().type == type;
   }
 
   bool empty() const
   {
-    return remaining == 0;
+    return this->anyPopped && this->popped.type == TokenType::End;
   }
 
   Scope* getScope() { return scopeStack.back(); }
@@ -80,233 +107,182 @@ public:
   void popScope() { scopeStack.pop_back(); }
 
   template<typename T> T* makeNode() { return ast.makeNode<T>(); }
+  template<typename T> NodeRef<T> addNode(T node = T()) { return ast.addNode(std::move(node)); }
+  template<typename T> T* get(NodeRef<T> ref) { return ast.get(ref); }
+
+  // Child lists are built up on a scratch stack for their element type, then copied into the ast in one piece when
+  // they're complete. Lists of the same type can nest (a statement in a block can contain a block), which works
+  // because an inner list is always finished before anything more is added to the outer one.
+  template<typename T> uint32_t beginList() { return uint32_t(std::get<std::vector<T>>(this->scratchLists).size()); }
+  template<typename T> void pushToList(T item) { std::get<std::vector<T>>(this->scratchLists).push_back(item); }
+
+  template<typename T> ArenaList<T> endList(uint32_t start)
+  {
+    std::vector<T>& scratch = std::get<std::vector<T>>(this->scratchLists);
+    debug_assert(start <= scratch.size());
+
+    ArenaList<T> list = ast.makeList(scratch.data() + start, scratch.size() - start);
+    scratch.resize(start);
+    return list;
+  }
 
 public:
   AstChunk& ast;
 
   std::vector<Scope*> scopeStack;
-  const Token* next = nullptr;
-  size_t remaining = 0;
-  const Token* popped = nullptr;
+
+  std::tuple<
+    std::vector<Func*>,
+    std::vector<VariableDeclaration*>,
+    std::vector<NodeRef<Statement>>,
+    std::vector<NodeRef<IfElseChainItem>>,
+    std::vector<NodeRef<Expression>>> scratchLists;
+
+  TokenReader reader;
+  Token popped;
+  bool anyPopped = false;
 };
 
-void parse(AstChunk& ast, const std::vector<Token>& tokens)
+void parse(AstChunk& ast, std::string_view source)
 {
-  Parser parser(ast, tokens.data(), tokens.size());
+  Parser parser(ast, source);
   ast.root = parser.parseRoot();
 }
 
-Expression* Parser::resolveIntermediateExpression(IntermediateExpression&& intermediate)
+// Higher binds tighter, 0 for anything that isn't a binary operator. See https://en.cppreference.com/w/c/language/operator_precedence
+static int32_t getBinaryPrecedence(Op::Type op)
 {
-  auto outputOp = [&](Op::Type op, int32_t& i)
+  switch (op)
   {
-    Op* opNode = makeNode<Op>();
-
-    switch (op)
-    {
-      case Op::Type::Call:
-      {
-        IntermediateExpressionItem& callable = intermediate[i-1];
-        IntermediateExpressionItem& args = intermediate[i+1];
-
-        Op::Call call;
-        call.callable = callable.val.expression();
-        call.callArgs = std::move(args.val.callArgs());
-        intermediate.erase(intermediate.begin() + i, intermediate.begin() + (i+2));
-
-        opNode->type = op;
-        Expression* expression = makeNode<Expression>();
-        expression->val = opNode;
-        expression->source = SourceRange(call.callable->source.start, args.source.end);
-        opNode->args = std::move(call);
-
-        intermediate[i-1] = IntermediateExpressionItem(expression, expression->source);
-        i -= 2;
-        break;
-      }
-      case Op::Type::Subscript:
-      {
-        Op::Subscript subscript;
-        subscript.item = intermediate[i-1].val.expression();
-        subscript.index = intermediate[i+1].val.expression();
-        intermediate.erase(intermediate.begin() + i, intermediate.begin() + (i+2));
-
-        opNode->type = op;
-        Expression* expression = makeNode<Expression>();
-        expression->val = opNode;
-        expression->source = SourceRange(subscript.item->source.start, subscript.index->source.end);
-        opNode->args = std::move(subscript);
-
-        intermediate[i-1] = IntermediateExpressionItem(expression, expression->source);
-        i -= 2;
-        break;
-      }
-      case Op::Type::LogicalNot:
-      case Op::Type::UnaryMinus:
-      case Op::Type::AddressOf:
-      {
-        Op::Unary unary;
-        unary.expression = intermediate[i+1].val.expression();
-        intermediate.erase(intermediate.begin() + i, intermediate.begin() + (i+1));
-
-        opNode->type = op;
-        Expression* expression = makeNode<Expression>();
-        expression->val = opNode;
-        expression->source = SourceRange(intermediate[i].source.start, unary.expression->source.end);
-        opNode->args = std::move(unary);
-
-        intermediate[i] = IntermediateExpressionItem(expression, expression->source);
-        break;
-      }
-      case Op::Type::MemberAccess:
-      {
-        SourceRange range(intermediate[i-1].source.start, intermediate[i+1].source.end);
-
-        Op::MemberAccess memberAccess;
-        memberAccess.expression = intermediate[i-1].val.expression();
-        memberAccess.member = intermediate[i+1].val.expression()->val.id();
-        intermediate.erase(intermediate.begin() + i, intermediate.begin() + (i+2));
-
-        opNode->type = op;
-        Expression* expression = makeNode<Expression>();
-        expression->val = opNode;
-        expression->source = range;
-        opNode->args = std::move(memberAccess);
-
-        intermediate[i-1] = IntermediateExpressionItem(expression, expression->source);
-        i -= 2;
-        break;
-      }
-      case Op::Type::Add:
-      case Op::Type::Subtract:
-      case Op::Type::Multiply:
-      case Op::Type::Divide:
-      case Op::Type::CompareEqual:
-      case Op::Type::CompareNotEqual:
-      case Op::Type::LogicalAnd:
-      case Op::Type::LogicalOr:
-      {
-        Op::Binary binary;
-        binary.left = intermediate[i-1].val.expression();
-        binary.right = intermediate[i+1].val.expression();
-        intermediate.erase(intermediate.begin() + i, intermediate.begin() + (i+2));
-
-        opNode->type = op;
-        Expression* expression = makeNode<Expression>();
-        expression->val = opNode;
-        expression->source = SourceRange(binary.left->source.start, binary.right->source.end);
-        opNode->args = std::move(binary);
-
-        intermediate[i-1] = IntermediateExpressionItem(expression, expression->source);
-        i -= 2;
-        break;
-      }
-
-      case Op::Type::ENUM_END:
-        release_assert(false);
-    }
-  };
+    case Op::Type::Multiply:
+    case Op::Type::Divide:
+      return 5;
+    case Op::Type::Add:
+    case Op::Type::Subtract:
+      return 4;
+    case Op::Type::CompareEqual:
+    case Op::Type::CompareNotEqual:
+      return 3;
+    case Op::Type::LogicalAnd:
+      return 2;
+    case Op::Type::LogicalOr:
+      return 1;
+    default:
+      return 0;
+  }
+}
 
+// Precedence climbing, so each item is visited once. All the binary operators are left associative.
+NodeRef<Expression> Parser::resolveIntermediateExpression(IntermediateExpression&& intermediate)
+{
 #ifndef NDEBUG
   for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
-  {
-    release_assert(intermediate[i].source.start > SourceLocation());
     release_assert(intermediate[i].source.end > intermediate[i].source.start);
-  }
 #endif
 
-  // See https://en.cppreference.com/w/c/language/operator_precedence
+  int32_t i = 0;
+  NodeRef<Expression> expression = resolveBinary(intermediate, i, 1);
+  debug_assert(i == int32_t(intermediate.size()));
+  return expression;
+}
 
-  // group 1
-  for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
-  {
-    if (!intermediate[i].val.isOp())
-      continue;
-    Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::Call || op == Op::Type::MemberAccess || op == Op::Type::Subscript)
-      outputOp(op, i);
-  }
+// Resolves everything from i up to the first binary operator that binds looser than minimumPrecedence
+NodeRef<Expression> Parser::resolveBinary(IntermediateExpression& intermediate, int32_t& i, int32_t minimumPrecedence)
+{
+  NodeRef<Expression> left = resolveUnary(intermediate, i);
 
-  // group 2
-  for (int32_t i = int32_t(intermediate.size()) - 1; i >= 0; i--)
+  while (i < int32_t(intermediate.size()))
   {
-    if (!intermediate[i].val.isOp())
-      continue;
     Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::LogicalNot || op == Op::Type::UnaryMinus || op == Op::Type::AddressOf)
-      outputOp(op, i);
-  }
+    int32_t precedence = getBinaryPrecedence(op);
+    release_assert(precedence > 0);
+    if (precedence < minimumPrecedence)
+      break;
+    i++;
 
-  // group 3
-  for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
-  {
-    if (!intermediate[i].val.isOp())
-      continue;
-    Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::Multiply || op == Op::Type::Divide)
-      outputOp(op, i);
-  }
+    NodeRef<Expression> right = resolveBinary(intermediate, i, precedence + 1);
+    SourceRange source(get(left)->source.start, get(right)->source.end);
 
-  // group 4
-  for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
-  {
-    if (!intermediate[i].val.isOp())
-      continue;
-    Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::Add || op == Op::Type::Subtract)
-      outputOp(op, i);
+    left = makeOpExpression(op, Op::Binary { .left = left, .right = right }, source);
   }
 
-  // group 7
-  for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
-  {
-    if (!intermediate[i].val.isOp())
-      continue;
-    Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::CompareEqual || op == Op::Type::CompareNotEqual)
-      outputOp(op, i);
-  }
+  return left;
+}
 
-  // group 11
-  for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
+// One operand with its prefix and postfix operators. Postfix operators bind tighter, and apply left to right,
+// then the prefix ones apply right to left.
+NodeRef<Expression> Parser::resolveUnary(IntermediateExpression& intermediate, int32_t& i)
+{
+  int32_t prefixStart = i;
+  while (intermediate[i].val.isOp())
+    i++;
+  int32_t prefixEnd = i;
+
+  NodeRef<Expression> expression = intermediate[i].val.expression();
+  i++;
+
+  while (i < int32_t(intermediate.size()))
   {
-    if (!intermediate[i].val.isOp())
-      continue;
     Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::LogicalAnd)
-      outputOp(op, i);
+
+    if (op == Op::Type::Call)
+    {
+      IntermediateExpressionItem& args = intermediate[i+1];
+      SourceRange source(get(expression)->source.start, args.source.end);
+
+      expression = makeOpExpression(op, Op::Call { .callable = expression, .callArgs = std::move(args.val.callArgs()) }, source);
+    }
+    else if (op == Op::Type::Subscript)
+    {
+      NodeRef<Expression> index = intermediate[i+1].val.expression();
+      SourceRange source(get(expression)->source.start, get(index)->source.end);
+
+      expression = makeOpExpression(op, Op::Subscript { .item = expression, .index = index }, source);
+    }
+    else if (op == Op::Type::MemberAccess)
+    {
+      SourceRange source(get(expression)->source.start, intermediate[i+1].source.end);
+
+      ScopeId member = get(intermediate[i+1].val.expression())->val.id();
+      expression = makeOpExpression(op, Op::MemberAccess { .expression = expression, .member = std::move(member) }, source);
+    }
+    else
+    {
+      break;
+    }
+
+    i += 2;
   }
 
-  // group 12
-  for (int32_t i = 0; i < int32_t(intermediate.size()); i++)
+  for (int32_t prefix = prefixEnd - 1; prefix >= prefixStart; prefix--)
   {
-    if (!intermediate[i].val.isOp())
-      continue;
-    Op::Type op = intermediate[i].val.op();
-    if (op == Op::Type::LogicalOr)
-      outputOp(op, i);
+    Op::Type op = intermediate[prefix].val.op();
+    release_assert(op == Op::Type::LogicalNot || op == Op::Type::UnaryMinus || op == Op::Type::AddressOf);
+
+    SourceRange source(intermediate[prefix].source.start, get(expression)->source.end);
+
+    expression = makeOpExpression(op, Op::Unary { .expression = expression }, source);
   }
 
-  debug_assert(intermediate.size() == 1);
-  return intermediate[0].val.expression();
+  return expression;
 }
 
-std::string Parser::parseId()
+Symbol Parser::parseId()
 {
-  release_assert(peek().type == Token::Type::Id);
-  return pop().idValue;
+  release_assert(peek() == TokenType::Id);
+  return Symbol(this->reader.getText(pop()));
 }
 
 IntegerToken Parser::parseIntegerToken()
 {
-  release_assert(peek().type == Token::Type::IntegerToken);
-  return pop().integerValue;
+  release_assert(peek() == TokenType::IntegerToken);
+  return this->reader.getInteger(pop());
 }
 
-std::string Parser::parseString()
+Symbol Parser::parseString()
 {
-  release_assert(peek().type == Token::Type::String);
-  return pop().stringValue;
+  release_assert(peek() == TokenType::String);
+  return Symbol(this->reader.getText(pop()));
 }
 
 #include "ParserRules.inl"
@@ -1,4 +1,5 @@
 #pragma once
 #include "AstChunk.hpp"
 
-void parse(AstChunk& ast, const std::vector<Token>& tokens);
+// Tokenises the source as it goes, with a TokenReader
+void parse(AstChunk& ast, std::string_view source);
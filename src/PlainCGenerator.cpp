@@ -3,11 +3,27 @@
 #include "Common/Assert.hpp"
 #include <unordered_map>
 #include <functional>
+#include <algorithm>
 
 
 PlainCGenerator::PlainCGenerator() {}
 
 std::string PlainCGenerator::output()
+{
+  return this->outputDeclarations() + this->outputStringConstants() + this->functionBodies.str;
+}
+
+std::string PlainCGenerator::output(std::string_view sharedHeaderName)
+{
+  return "#include \"" + std::string(sharedHeaderName) + "\"\n" + this->outputStringConstants() + this->functionBodies.str;
+}
+
+std::string PlainCGenerator::outputSharedHeader()
+{
+  return "#ifndef WLANG_TYPES_H\n#define WLANG_TYPES_H\n" + this->outputDeclarations() + "#endif\n";
+}
+
+std::string PlainCGenerator::outputDeclarations()
 {
   OutputString declarations;
 
@@ -52,11 +68,20 @@ std::string PlainCGenerator::output()
     seenThisIteration.erase(type);
   };
 
-  for (const Type* type : this->usedTypesByValue)
+  // Everything below is emitted in sorted order, so the same input always generates byte-identical output.
+  // The build manifest relies on this to skip recompiling unchanged functions.
+  auto sortedByName = [](const std::unordered_set<const Type*>& types)
+  {
+    std::vector<const Type*> sorted(types.begin(), types.end());
+    std::sort(sorted.begin(), sorted.end(), [](const Type* a, const Type* b) { return a->name.str() < b->name.str(); });
+    return sorted;
+  };
+
+  for (const Type* type : sortedByName(this->usedTypesByValue))
     evalType(type);
 
-  for (const Type* type : allTypesUsedByReference)
-    declarations.appendLine("struct " + type->name + ";");
+  for (const Type* type : sortedByName(allTypesUsedByReference))
+    declarations.appendLine("struct " + std::string(type->name.str()) + ";");
 
   for (const Type* type : sortedTypes)
   {
@@ -64,48 +89,62 @@ std::string PlainCGenerator::output()
       this->generateClassDeclaration(type->typeClass, declarations);
   }
 
-  for (const Func* function : this->usedFunctions)
+  std::vector<const Func*> sortedFunctions(this->usedFunctions.begin(), this->usedFunctions.end());
+  std::sort(sortedFunctions.begin(), sortedFunctions.end(), [](const Func* a, const Func* b) { return a->mangledName.str() < b->mangledName.str(); });
+  for (const Func* function : sortedFunctions)
     declarations.appendLine(this->getPrototype(function) + ";");
 
+  return declarations.str;
+}
+
+std::string PlainCGenerator::outputStringConstants()
+{
+  std::vector<std::pair<std::string_view, std::string_view>> sortedStringConstants(this->stringConstants.begin(), this->stringConstants.end());
+  std::sort(sortedStringConstants.begin(), sortedStringConstants.end());
+
   OutputString stringConstantsOutput;
-  for (const auto& pair : this->stringConstants)
+  for (const auto& pair : sortedStringConstants)
   {
-    std::string charArrayName = pair.second + "_charArray";
-    stringConstantsOutput.appendLine("static const char " + charArrayName + "[] = " + pair.first + ";");
-    stringConstantsOutput.appendLine("static struct string " + pair.second + " = { .data = (char*)" + charArrayName + ", .length = sizeof(" + charArrayName + ") - 1, .capacity = -1 };");
+    std::string charArrayName = std::string(pair.second) + "_charArray";
+    stringConstantsOutput.appendLine("static const char " + charArrayName + "[] = " + std::string(pair.first) + ";");
+    stringConstantsOutput.appendLine("static struct string " + std::string(pair.second) + " = { .data = (char*)" + charArrayName + ", .length = sizeof(" + charArrayName + ") - 1, .capacity = -1 };");
   }
 
-  return declarations.str + stringConstantsOutput.str + functionBodies.str;
+  return stringConstantsOutput.str;
 }
 
-void PlainCGenerator::generate(const Root *root)
+void PlainCGenerator::generate(const AstChunk& chunk)
 {
-  generate(root->funcList);
+  for (const Func* func : chunk.root->funcList->functions)
+    generate(chunk, func);
 }
 
-static const std::unordered_map<std::string, std::string> builtinTypeMapping
+void PlainCGenerator::declare(const Root* root)
 {
-  {"i8", "char"},
-  {"i16", "short"},
-  {"i32", "int"},
-  {"i64", "long long int"},
-  {"bool", "char"}
-};
+  for (const Class* classN : root->funcList->classes)
+    this->referenceType(classN->type->reference());
 
-void PlainCGenerator::generate(const FuncList* node)
-{
-  for (Func* func : node->functions)
-    generate(func);
+  for (const Func* function : root->funcList->functions)
+    this->referenceFunction(function);
 }
 
+static const SymbolMap<std::string> builtinTypeMapping
+{
+  {Symbol("i8"), "char"},
+  {Symbol("i16"), "short"},
+  {Symbol("i32"), "int"},
+  {Symbol("i64"), "long long int"},
+  {Symbol("bool"), "char"}
+};
+
 std::string PlainCGenerator::getPrototype(const Func* node)
 {
-  std::string prototype= strType(node->returnType) + " " + node->mangledName + "(";
+  std::string prototype= strType(node->returnType) + " " + std::string(node->mangledName.str()) + "(";
 
   for (VariableDeclaration* var : node->args)
   {
     release_assert(!var->initialiser);
-    prototype += strType(var->type) + " " + var->name;
+    prototype += strType(var->type) + " " + std::string(var->name.str());
     prototype += ", ";
   }
 
@@ -117,24 +156,28 @@ std::string PlainCGenerator::getPrototype(const Func* node)
   return prototype;
 }
 
-void PlainCGenerator::generate(const Func* node)
+void PlainCGenerator::generate(const AstChunk& chunk, const Func* node)
 {
   if (node->external)
     return;
 
+  this->chunk = &chunk;
+
   std::string prototype = getPrototype(node);
 
   functionBodies.appendLine(prototype);
-  generate(node->funcBody, functionBodies);
+  generate(get(node->funcBody), functionBodies);
   functionBodies.appendLine();
+
+  this->chunk = nullptr;
 }
 
 void PlainCGenerator::generate(const Block* block, OutputString& str)
 {
   str.appendLine("{");
   {
-    for (const Statement* statement : block->statements)
-      generate(statement, str);
+    for (NodeRef<Statement> statement : block->statements)
+      generate(get(statement), str);
   }
   str.appendLine("}");
 }
@@ -145,7 +188,7 @@ void PlainCGenerator::generate(const Statement* node, OutputString& str)
   {
     case Statement::Tag::Return:
     {
-      str.appendLine("return " + generate(node->returnStatment()->retval) + ";");
+      str.appendLine("return " + generate(get(get(node->returnStatment())->retval)) + ";");
       break;
     }
     case Statement::Tag::Variable:
@@ -155,21 +198,21 @@ void PlainCGenerator::generate(const Statement* node, OutputString& str)
     }
     case Statement::Tag::Assignment:
     {
-      Assignment* assignment = node->assignment();
-      str.appendLine(generate(assignment->left) + " = " +  generate(assignment->right) + ";");
+      const Assignment* assignment = get(node->assignment());
+      str.appendLine(generate(get(assignment->left)) + " = " +  generate(get(assignment->right)) + ";");
       break;
     }
     case Statement::Tag::Expression:
     {
-      str.appendLine(generate(node->expression()) + ";");
+      str.appendLine(generate(get(node->expression())) + ";");
       break;
     }
     case Statement::Tag::IfElseChain:
     {
-      IfElseChain* ifElseChain = node->ifElseChain();
+      const IfElseChain* ifElseChain = get(node->ifElseChain());
       for (int32_t i = 0; i < int32_t(ifElseChain->items.size()); i++)
       {
-        IfElseChainItem* item = ifElseChain->items[i];
+        const IfElseChainItem* item = get(ifElseChain->items[i]);
 
         std::string line;
         if (i == 0)
@@ -182,12 +225,12 @@ void PlainCGenerator::generate(const Statement* node, OutputString& str)
         if (item->condition)
         {
           line += " (";
-          line += generate(item->condition);
+          line += generate(get(item->condition));
           line += ")";
         }
 
         str.appendLine(line);
-        generate(item->block, str);
+        generate(get(item->block), str);
       }
       break;
     }
@@ -208,11 +251,11 @@ void PlainCGenerator::generate(const VariableDeclaration* variableDeclaration, O
   if (typeClass)
   {
     release_assert(!variableDeclaration->initialiser && "not supported yet");
-    line += strType(variableDeclaration->type) + " " + variableDeclaration->name;// + "; ";
+    line += strType(variableDeclaration->type) + " " + std::string(variableDeclaration->name.str());// + "; ";
   }
   else
   {
-    line += strType(variableDeclaration->type) + " " + variableDeclaration->name;
+    line += strType(variableDeclaration->type) + " " + std::string(variableDeclaration->name.str());
   }
 
   std::string line2;
@@ -221,12 +264,12 @@ void PlainCGenerator::generate(const VariableDeclaration* variableDeclaration, O
     if (variableDeclaration->initialiser)
     {
       line += " = ";
-      line += generate(variableDeclaration->initialiser);
+      line += generate(get(variableDeclaration->initialiser));
     }
     else if (variableDeclaration->type.pointerDepth == 0 && variableDeclaration->type.id.resolved.type()->typeClass)
     {
-      const Func* defaultConstructor = variableDeclaration->type.id.resolved.type()->typeClass->memberScope->functions.at("defaultConstruct").item;
-      line2 = defaultConstructor->mangledName + "(&" + variableDeclaration->name + ")";
+      const Func* defaultConstructor = variableDeclaration->type.id.resolved.type()->typeClass->memberScope->functions.at(Symbol("defaultConstruct")).item;
+      line2 = std::string(defaultConstructor->mangledName.str()) + "(&" + std::string(variableDeclaration->name.str()) + ")";
       this->referenceFunction(defaultConstructor);
     }
   }
@@ -245,7 +288,7 @@ std::string PlainCGenerator::generate(const Expression* node)
     case Expression::Val::Tag::Id:
     {
       const ScopeId& scopeId = node->val.id();
-      str += scopeId.str;
+      str += scopeId.name.str();
       break;
     }
 
@@ -274,10 +317,10 @@ std::string PlainCGenerator::generate(const Expression* node)
 
     case Expression::Val::Tag::StringConstant:
     {
-      const std::string& string = node->val.stringConstant().val;
+      std::string_view string = node->val.stringConstant().val.str();
       auto it = this->stringConstants.find(string);
       if (it == this->stringConstants.end())
-        it = this->stringConstants.insert_or_assign(string, "str_" + std::to_string(this->stringConstants.size())).first;
+        it = this->stringConstants.insert_or_assign(std::string(string), "str_" + std::to_string(this->stringConstants.size())).first;
       str += it->second;
       break;
     }
@@ -296,7 +339,7 @@ std::string PlainCGenerator::generate(const Expression* node)
 
     case Expression::Val::Tag::Op:
     {
-      const Op* opNode = node->val.op();
+      const Op* opNode = get(node->val.op());
 
       switch (opNode->type)
       {
@@ -304,9 +347,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " + ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -314,9 +357,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
          const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " - ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -324,9 +367,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " * ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -334,9 +377,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
          const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " / ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -344,9 +387,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " == ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -354,9 +397,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " != ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -364,9 +407,9 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " && ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
@@ -374,64 +417,66 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Binary& binary = opNode->args.binary();
           str += "(";
-          str += generate(binary.left);
+          str += generate(get(binary.left));
           str += " || ";
-          str += generate(binary.right);
+          str += generate(get(binary.right));
           str += ")";
           break;
         }
         case Op::Type::MemberAccess:
         {
           const Op::MemberAccess& memberAccess = opNode->args.memberAccess();
-          TypeRef parentType = memberAccess.expression->type;
+          const Expression* object = get(memberAccess.expression);
+          TypeRef parentType = object->type;
           parentType.pointerDepth--;
           this->referenceType(parentType);
           str += "(";
-          str += generate(memberAccess.expression);
+          str += generate(object);
 
-          if (memberAccess.expression->type.pointerDepth == 0)
+          if (object->type.pointerDepth == 0)
             str += ".";
           else
             str += "->";
 
-          str += memberAccess.member.str;
+          str += memberAccess.member.name.str();
           str += ")";
           break;
         }
         case Op::Type::LogicalNot:
         {
           str += "(!";
-          str += generate(opNode->args.unary().expression);
+          str += generate(get(opNode->args.unary().expression));
           str += ")";
           break;
         }
         case Op::Type::UnaryMinus:
         {
           str += "(-";
-          str += generate(opNode->args.unary().expression);
+          str += generate(get(opNode->args.unary().expression));
           str += ")";
           break;
         }
         case Op::Type::AddressOf:
         {
           str += "(&";
-          str += generate(opNode->args.unary().expression);
+          str += generate(get(opNode->args.unary().expression));
           str += ")";
           break;
         }
         case Op::Type::Call:
         {
           const Op::Call& call = opNode->args.call();
-          if (call.callable->val.isId())
+          const Expression* callable = get(call.callable);
+          if (callable->val.isId())
           {
-            const Func* function = call.callable->val.id().resolved.function();
+            const Func* function = callable->val.id().resolved.function();
             this->referenceFunction(function);
             str += "((";
-            str += function->mangledName;
+            str += function->mangledName.str();
             str += ")(";
             for (int32_t i = 0; i < int32_t(call.callArgs.size()); i++)
             {
-              str += generate(call.callArgs[i]);
+              str += generate(get(call.callArgs[i]));
               if (i != int32_t(call.callArgs.size()) - 1)
                 str += ", ";
             }
@@ -440,25 +485,25 @@ std::string PlainCGenerator::generate(const Expression* node)
           else
           {
             // is member call
-            const Op* callOp = call.callable->val.op();
-            const Expression* object = callOp->args.memberAccess().expression;
+            const Op* callOp = get(callable->val.op());
+            const Expression* object = get(callOp->args.memberAccess().expression);
 
             if (object->type.id.resolved.type()->builtin)
               break;
 
             this->referenceFunction(callOp->args.memberAccess().member.resolved.function());
 
-            str += "("+ callOp->args.memberAccess().member.resolved.function()->mangledName + "(";
+            str += "("+ std::string(callOp->args.memberAccess().member.resolved.function()->mangledName.str()) + "(";
 
-            if (callOp->args.memberAccess().expression->type.pointerDepth == 0)
+            if (object->type.pointerDepth == 0)
               str += "&";
-            str += "(" + generate(callOp->args.memberAccess().expression) + ")";
+            str += "(" + generate(object) + ")";
 
             if (!call.callArgs.empty())
               str += ", ";
             for (int32_t i = 0; i < int32_t(call.callArgs.size()); i++)
             {
-              str += generate(call.callArgs[i]);
+              str += generate(get(call.callArgs[i]));
               if (i != int32_t(call.callArgs.size()) - 1)
                 str += ", ";
             }
@@ -470,10 +515,10 @@ std::string PlainCGenerator::generate(const Expression* node)
         {
           const Op::Subscript& subscript = opNode->args.subscript();
           str += "((";
-          str += generate(subscript.item);
+          str += generate(get(subscript.item));
           str += ")";
           str += "[";
-          str += generate(subscript.index);
+          str += generate(get(subscript.index));
           str += "])";
           break;
         }
@@ -493,7 +538,7 @@ std::string PlainCGenerator::generate(const Expression* node)
 
 void PlainCGenerator::generateClassDeclaration(const Class* node, OutputString& str)
 {
-  str.appendLine("struct " + node->type->name);
+  str.appendLine("struct " + std::string(node->type->name.str()));
   str.appendLine("{");
 
   for (VariableDeclaration* variableDeclaration : node->memberVariables)
@@ -508,9 +553,9 @@ std::string PlainCGenerator::strType(const TypeRef& type)
   std::string str;
 
   if (type.id.resolved.type()->typeClass)
-    str += "struct " + type.id.resolved.type()->name;
+    str += "struct " + std::string(type.id.resolved.type()->name.str());
   else
-    str += builtinTypeMapping.at(type.id.str);
+    str += builtinTypeMapping.at(type.id.name);
 
   for (int i = 0; i < type.pointerDepth; i++)
     str += "*";
@@ -1,24 +1,33 @@
 #pragma once
 #include "Ast.hpp"
+#include "AstChunk.hpp"
 #include "OutputString.hpp"
+#include "HashMap.hpp"
 
 class PlainCGenerator
 {
 public:
   PlainCGenerator();
 
+  // Self contained C source, declaring everything it uses
   std::string output();
+  // C source that gets all its declarations from a header made by outputSharedHeader()
+  std::string output(std::string_view sharedHeaderName);
+  // Every type and function passed to declare(), for sharing (and precompiling) between translation units
+  std::string outputSharedHeader();
 
-  void generate(const Root* root);
-  void generate(const Func* node);
+  void generate(const AstChunk& chunk);
+  void generate(const AstChunk& chunk, const Func* node);
+  void declare(const Root* root);
 
 private:
+  std::string outputDeclarations();
+  std::string outputStringConstants();
   void referenceType(const TypeRef& typeRef);
   void referenceFunction(const Func* function);
   std::string getPrototype(const Func* node);
   void generateClassDeclaration(const Class*, OutputString& str);
 
-  void generate(const FuncList* node);
   void generate(const Block* block, OutputString& str);
   void generate(const Statement* node, OutputString& str);
   std::string generate(const Expression* node);
@@ -26,12 +35,15 @@ private:
 //  void generate(const Class* node);
   std::string strType(const TypeRef& type);
 
+  template<typename T> const T* get(NodeRef<T> ref) const { return this->chunk->get(ref); }
+
 private:
   std::unordered_set<const Type*> usedTypesByRef;
   std::unordered_set<const Type*> usedTypesByValue;
   std::unordered_set<const Func*> usedFunctions;
   OutputString functionBodies;
   HashMap<std::string> stringConstants;
+  const AstChunk* chunk = nullptr; // the one holding the function being generated
 };
 
 
@@ -1,5 +1,6 @@
 #include "Process.hpp"
 #include "Common/Assert.hpp"
+#include <algorithm>
 
 #ifdef WIN32
 #include <windows.h>
@@ -185,17 +186,116 @@ done:
 
   return retval;
 }
+
+void ProcessPool::launch(uint64_t id, const std::vector<std::string>& args)
+{
+  RunningProcess& process = this->running.emplace_back();
+  process.id = id;
+  process.thread = std::thread([this, id, args]()
+  {
+    ProcessCompletion completion;
+    completion.id = id;
+    completion.launched = runProcess(args, completion.output, completion.exitCode);
+
+    std::scoped_lock lock(this->threadsMutex);
+    this->finishedByThreads.emplace_back(std::move(completion));
+    this->threadFinished.notify_one();
+  });
+}
+
+void ProcessPool::launchWithInput(uint64_t, const std::vector<std::string>&, std::string_view)
+{
+  message_and_abort("process input isn't supported on windows");
+}
+
+bool ProcessPool::pollProcesses(int wakeFd)
+{
+  release_assert(wakeFd == -1);
+
+  std::deque<ProcessCompletion> finished;
+  {
+    std::unique_lock lock(this->threadsMutex);
+    this->threadFinished.wait(lock, [&]() { return !this->finishedByThreads.empty(); });
+    finished.swap(this->finishedByThreads);
+  }
+
+  for (ProcessCompletion& completion : finished)
+  {
+    auto it = std::find_if(this->running.begin(), this->running.end(), [&](const RunningProcess& process) { return process.id == completion.id; });
+    release_assert(it != this->running.end());
+    it->thread.join();
+    this->running.erase(it);
+
+    this->completed.emplace_back(std::move(completion));
+  }
+
+  return false;
+}
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <csignal>
+#include <spawn.h>
 #include <sys/wait.h>
 #include "UnixWrap.hpp"
 
+extern char** environ;
+
 enum PIPE_FILE_DESCRIPTORS
 {
   READ_FD  = 0,
   WRITE_FD = 1
 };
 
+// Both ends close on exec, so children started on other threads don't inherit them. If a child kept the write end of
+// another child's pipe open, that pipe would never reach end of file. The child's own stdin, stdout and stderr are
+// dup2'd copies, which don't inherit the flag.
+static void createPipe(int fds[2])
+{
+#if defined(linux)
+  release_assert(pipe2(fds, O_CLOEXEC) == 0);
+#else
+  // no pipe2 on macOS, so there's a window where a fork on another thread can still inherit these
+  release_assert(pipe(fds) == 0);
+  release_assert(fcntl(fds[READ_FD], F_SETFD, FD_CLOEXEC) == 0);
+  release_assert(fcntl(fds[WRITE_FD], F_SETFD, FD_CLOEXEC) == 0);
+#endif
+}
+
+// Like w_write(), but writing to a pipe whose reader has gone fails with EPIPE instead of killing us with SIGPIPE.
+// The signal is blocked on this thread just for the write, and taken off the pending set if the write raised it,
+// rather than ignoring it for the whole process.
+static ssize_t writeWithoutSigpipe(int fd, const void* data, size_t size)
+{
+  sigset_t sigpipeSet;
+  sigemptyset(&sigpipeSet);
+  sigaddset(&sigpipeSet, SIGPIPE);
+
+  sigset_t oldMask;
+  release_assert(pthread_sigmask(SIG_BLOCK, &sigpipeSet, &oldMask) == 0);
+
+  // if one was already pending it isn't ours to take
+  sigset_t pending;
+  release_assert(sigpending(&pending) == 0);
+  bool wasPending = sigismember(&pending, SIGPIPE);
+
+  ssize_t bytesWritten = w_write(fd, data, size);
+  int writeErrno = errno;
+
+  if (bytesWritten < 0 && writeErrno == EPIPE && !wasPending)
+  {
+    release_assert(sigpending(&pending) == 0);
+    int signalNumber = 0;
+    if (sigismember(&pending, SIGPIPE))
+      release_assert(sigwait(&sigpipeSet, &signalNumber) == 0);
+  }
+
+  release_assert(pthread_sigmask(SIG_SETMASK, &oldMask, nullptr) == 0);
+  errno = writeErrno;
+  return bytesWritten;
+}
+
 
 bool runProcess(const std::vector<std::string>& args, std::string& output, int32_t& exitCode, void* environmentPtr)
 {
@@ -215,13 +315,13 @@ bool runProcess(const std::vector<std::string>& args, std::string& output, int32
   char buffer[bufferSize + 1];
 
   int parentToChild[2];
-  release_assert(pipe(parentToChild) == 0);
+  createPipe(parentToChild);
 
   int childToParent[2];
-  release_assert(pipe(childToParent) == 0);
+  createPipe(childToParent);
 
   int errPipe[2];
-  release_assert(pipe(errPipe) == 0);
+  createPipe(errPipe);
 
   pid_t pid = fork();
   release_assert(pid != -1);
@@ -299,4 +399,215 @@ childError:
     }
   }
 }
+
+void ProcessPool::launch(uint64_t id, const std::vector<std::string>& args)
+{
+  this->spawn(id, args, false, std::string_view());
+}
+
+void ProcessPool::launchWithInput(uint64_t id, const std::vector<std::string>& args, std::string_view input)
+{
+  this->spawn(id, args, true, input);
+}
+
+void ProcessPool::spawn(uint64_t id, const std::vector<std::string>& args, bool hasInput, std::string_view input)
+{
+  std::vector<char*> argvArray;
+  {
+    argvArray.reserve(args.size() + 1);
+    for (const std::string& arg: args)
+      argvArray.emplace_back((char*)arg.data());
+    argvArray.emplace_back(nullptr);
+  }
+
+  // Children launched later must not inherit these pipes, or we won't see end of file until they exit too
+  int outputPipe[2];
+  createPipe(outputPipe);
+
+  int inputPipe[2] = {-1, -1};
+  if (hasInput)
+  {
+    createPipe(inputPipe);
+
+    // we feed the input in as the child is ready for it, alongside everything else in the pool
+    release_assert(fcntl(inputPipe[WRITE_FD], F_SETFL, O_NONBLOCK) == 0);
+  }
+
+  posix_spawn_file_actions_t fileActions;
+  release_assert(posix_spawn_file_actions_init(&fileActions) == 0);
+  if (hasInput)
+    release_assert(posix_spawn_file_actions_adddup2(&fileActions, inputPipe[READ_FD], STDIN_FILENO) == 0);
+  else
+    release_assert(posix_spawn_file_actions_addopen(&fileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0) == 0);
+  release_assert(posix_spawn_file_actions_adddup2(&fileActions, outputPipe[WRITE_FD], STDOUT_FILENO) == 0);
+  release_assert(posix_spawn_file_actions_adddup2(&fileActions, outputPipe[WRITE_FD], STDERR_FILENO) == 0);
+
+  pid_t pid = 0;
+  int error = posix_spawnp(&pid, argvArray[0], &fileActions, nullptr, argvArray.data(), environ);
+  posix_spawn_file_actions_destroy(&fileActions);
+
+  release_assert(w_close(outputPipe[WRITE_FD]) == 0);
+  if (hasInput)
+    release_assert(w_close(inputPipe[READ_FD]) == 0);
+
+  if (error != 0)
+  {
+    release_assert(w_close(outputPipe[READ_FD]) == 0);
+    if (hasInput)
+      release_assert(w_close(inputPipe[WRITE_FD]) == 0);
+
+    ProcessCompletion& completion = this->completed.emplace_back();
+    completion.id = id;
+    completion.launched = false;
+    return;
+  }
+
+  RunningProcess& process = this->running.emplace_back();
+  process.id = id;
+  process.pid = pid;
+  process.outputFd = outputPipe[READ_FD];
+  process.inputFd = inputPipe[WRITE_FD];
+  process.input = input;
+
+  if (process.inputFd != -1 && process.input.empty())
+    process.closeInput();
+}
+
+void ProcessPool::RunningProcess::closeInput()
+{
+  release_assert(w_close(this->inputFd) == 0);
+  this->inputFd = -1;
+  this->input = std::string_view();
+}
+
+bool ProcessPool::pollProcesses(int wakeFd)
+{
+  // every output first, then the inputs still being written, then wakeFd
+  std::vector<pollfd> pollFds;
+  pollFds.reserve(this->running.size() * 2 + 1);
+  for (const RunningProcess& process : this->running)
+    pollFds.push_back({.fd = process.outputFd, .events = POLLIN, .revents = 0});
+
+  std::vector<size_t> writingProcesses;
+  for (size_t i = 0; i < this->running.size(); i++)
+  {
+    if (this->running[i].inputFd != -1)
+    {
+      pollFds.push_back({.fd = this->running[i].inputFd, .events = POLLOUT, .revents = 0});
+      writingProcesses.emplace_back(i);
+    }
+  }
+
+  if (wakeFd != -1)
+    pollFds.push_back({.fd = wakeFd, .events = POLLIN, .revents = 0});
+
+  release_assert(w_poll(pollFds.data(), pollFds.size(), -1) > 0);
+
+  for (size_t i = 0; i < writingProcesses.size(); i++)
+  {
+    if (pollFds[this->running.size() + i].revents == 0)
+      continue;
+
+    RunningProcess& process = this->running[writingProcesses[i]];
+    ssize_t bytesWritten = writeWithoutSigpipe(process.inputFd, process.input.data(), process.input.size());
+    if (bytesWritten < 0)
+    {
+      // the child has stopped reading, it will tell us why through its output
+      release_assert(errno == EPIPE || errno == EAGAIN || errno == EWOULDBLOCK);
+      if (errno == EPIPE)
+        process.closeInput();
+      continue;
+    }
+
+    // closing is what tells the child it has everything
+    process.input.remove_prefix(bytesWritten);
+    if (process.input.empty())
+      process.closeInput();
+  }
+
+  // backwards, so finished processes can be removed as we go
+  for (size_t i = this->running.size(); i-- > 0;)
+  {
+    if (pollFds[i].revents == 0)
+      continue;
+
+    RunningProcess& process = this->running[i];
+
+    // read straight into the output string, growing it geometrically
+    constexpr size_t minimumReadSize = 4096;
+    size_t oldSize = process.output.size();
+    if (process.output.capacity() - oldSize < minimumReadSize)
+      process.output.reserve(std::max(process.output.capacity() * 2, oldSize + minimumReadSize));
+    process.output.resize(process.output.capacity());
+
+    ssize_t bytesRead = w_read(process.outputFd, process.output.data() + oldSize, process.output.size() - oldSize);
+    release_assert(bytesRead >= 0);
+    process.output.resize(oldSize + bytesRead);
+
+    if (bytesRead == 0) // End-of-File, the child has exited or is about to
+    {
+      release_assert(w_close(process.outputFd) == 0);
+      if (process.inputFd != -1)
+        process.closeInput();
+
+      int status = 0;
+      release_assert(w_waitpid(process.pid, &status, 0) == process.pid);
+
+      ProcessCompletion& completion = this->completed.emplace_back();
+      completion.id = process.id;
+      completion.launched = true;
+      completion.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+      completion.output = std::move(process.output);
+
+      this->running.erase(this->running.begin() + i);
+    }
+  }
+
+  return wakeFd != -1 && pollFds.back().revents != 0;
+}
 #endif
+
+ProcessPool::WaitResult ProcessPool::wait(ProcessCompletion& completion, int wakeFd)
+{
+  while (this->completed.empty())
+  {
+    if (this->running.empty())
+      return WaitResult::NothingRunning;
+    if (this->pollProcesses(wakeFd) && this->completed.empty())
+      return WaitResult::Woken;
+  }
+
+  completion = std::move(this->completed.front());
+  this->completed.pop_front();
+  return WaitResult::Completed;
+}
+
+ProcessPool::~ProcessPool()
+{
+  // don't leave zombies behind
+  ProcessCompletion completion;
+  while (this->wait(completion) != WaitResult::NothingRunning) {}
+}
+
+bool runTool(const std::vector<std::string>& args, std::string& output, void* environmentPtr)
+{
+  int32_t exitCode = 0;
+  if (!runProcess(args, output, exitCode, environmentPtr))
+  {
+    output = "couldn't run " + formatCommand(args);
+    return false;
+  }
+  return exitCode == 0;
+}
+
+std::string formatCommand(const std::vector<std::string>& args)
+{
+  std::string commandLine;
+  for (const std::string& arg : args)
+  {
+    if (!commandLine.empty())
+      commandLine += ' ';
+    commandLine += arg;
+  }
+  return commandLine;
+}
\ No newline at end of file
@@ -1,5 +1,85 @@
 #pragma once
+#include <cstdint>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
+#ifdef WIN32
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
-bool runProcess(const std::vector<std::string>& args, std::string& output, int32_t& exitCode, void* environmentPtr = nullptr);
\ No newline at end of file
+bool runProcess(const std::vector<std::string>& args, std::string& output, int32_t& exitCode, void* environmentPtr = nullptr);
+
+// Runs args like runProcess(), returning whether it exited with 0. If it couldn't be started, output says so and gives
+// the command line, instead of the caller having to treat that as an internal error.
+[[nodiscard]] bool runTool(const std::vector<std::string>& args, std::string& output, void* environmentPtr = nullptr);
+std::string formatCommand(const std::vector<std::string>& args); // for error messages, not for running
+
+struct ProcessCompletion
+{
+  uint64_t id = 0;
+  bool launched = false; // false if the process couldn't be started at all, eg the executable doesn't exist
+  int32_t exitCode = 0;
+  std::string output; // stdout and stderr, interleaved
+};
+
+// Runs many processes at once from a single thread. Children are spawned without copying our address space, and
+// their output is collected by polling all of them together, so keeping lots of compilers busy is cheap.
+// Windows can't poll pipes, so there each process gets a thread that runs it to completion with runProcess().
+class ProcessPool
+{
+public:
+  ProcessPool() = default;
+  ProcessPool(const ProcessPool&) = delete;
+  ProcessPool& operator=(const ProcessPool&) = delete;
+  ~ProcessPool(); // waits for anything still running
+
+  // id is up to the caller, it's passed back in the ProcessCompletion
+  void launch(uint64_t id, const std::vector<std::string>& args);
+
+  // Like launch(), but input is fed to the child's stdin. It isn't copied, so it must outlive the process.
+  void launchWithInput(uint64_t id, const std::vector<std::string>& args, std::string_view input);
+
+  enum class WaitResult
+  {
+    Completed,
+    Woken,
+    NothingRunning,
+  };
+
+  // Blocks until some launched process has finished, or wakeFd (if not -1) becomes readable.
+  [[nodiscard]] WaitResult wait(ProcessCompletion& completion, int wakeFd = -1);
+
+  int32_t getRunningCount() const { return int32_t(this->running.size()); }
+
+private:
+  void spawn(uint64_t id, const std::vector<std::string>& args, bool hasInput, std::string_view input);
+  bool pollProcesses(int wakeFd); // returns true if wakeFd is readable
+
+private:
+  struct RunningProcess
+  {
+    uint64_t id = 0;
+    int32_t pid = 0;
+    int outputFd = -1;
+    std::string output;
+    int inputFd = -1;
+    std::string_view input; // what's left to write
+#ifdef WIN32
+    std::thread thread;
+#endif
+
+    void closeInput();
+  };
+
+  std::vector<RunningProcess> running;
+  std::deque<ProcessCompletion> completed; // finished, but not handed out by wait() yet
+
+#ifdef WIN32
+  std::mutex threadsMutex;
+  std::condition_variable threadFinished;
+  std::deque<ProcessCompletion> finishedByThreads; // guarded by threadsMutex, moved into completed by pollProcesses()
+#endif
+};
\ No newline at end of file
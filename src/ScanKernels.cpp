@@ -0,0 +1,249 @@
+#include "ScanKernels.hpp"
+#include "Common/Assert.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define WLANG_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// MSVC can't compile avx2 code without enabling it for the whole file, so it only gets sse2
+#if defined(WLANG_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define WLANG_SCAN_AVX2 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Scan
+{
+  static bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+  static bool isIdentifier(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; }
+  static bool isStringSpecial(char c) { return c == '"' || c == '\\'; }
+
+  // Used by every implementation for whatever is left at the end that's too short for a full vector
+  static const char* skipWhitespaceScalar(const char* p, const char* end)
+  {
+    while (p < end && isWhitespace(*p))
+      p++;
+    return p;
+  }
+
+  static const char* skipIdentifierScalar(const char* p, const char* end)
+  {
+    while (p < end && isIdentifier(*p))
+      p++;
+    return p;
+  }
+
+  static const char* findNewlineScalar(const char* p, const char* end)
+  {
+    while (p < end && *p != '\n')
+      p++;
+    return p;
+  }
+
+  static const char* findStringSpecialScalar(const char* p, const char* end)
+  {
+    while (p < end && !isStringSpecial(*p))
+      p++;
+    return p;
+  }
+
+#ifdef WLANG_SCAN_SSE2
+  static const char* skipWhitespaceSse2(const char* p, const char* end)
+  {
+    for (; end - p >= 16; p += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)p);
+      __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+
+      uint32_t notSpace = ~uint32_t(_mm_movemask_epi8(space)) & 0xFFFF;
+      if (notSpace)
+        return p + std::countr_zero(notSpace);
+    }
+    return skipWhitespaceScalar(p, end);
+  }
+
+  static __m128i isIdentifierSse2(__m128i v)
+  {
+    // signed compares are fine, everything we're looking for is below 128
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+  }
+
+  static const char* skipIdentifierSse2(const char* p, const char* end)
+  {
+    for (; end - p >= 16; p += 16)
+    {
+      uint32_t notIdentifier = ~uint32_t(_mm_movemask_epi8(isIdentifierSse2(_mm_loadu_si128((const __m128i*)p)))) & 0xFFFF;
+      if (notIdentifier)
+        return p + std::countr_zero(notIdentifier);
+    }
+    return skipIdentifierScalar(p, end);
+  }
+
+  static const char* findNewlineSse2(const char* p, const char* end)
+  {
+    for (; end - p >= 16; p += 16)
+    {
+      uint32_t found = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8('\n'))));
+      if (found)
+        return p + std::countr_zero(found);
+    }
+    return findNewlineScalar(p, end);
+  }
+
+  static const char* findStringSpecialSse2(const char* p, const char* end)
+  {
+    for (; end - p >= 16; p += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)p);
+      __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+      uint32_t found = uint32_t(_mm_movemask_epi8(special));
+      if (found)
+        return p + std::countr_zero(found);
+    }
+    return findStringSpecialScalar(p, end);
+  }
+#endif
+
+#ifdef WLANG_SCAN_AVX2
+  TARGET_AVX2 static const char* skipWhitespaceAvx2(const char* p, const char* end)
+  {
+    for (; end - p >= 32; p += 32)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i*)p);
+      __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+
+      uint32_t notSpace = ~uint32_t(_mm256_movemask_epi8(space));
+      if (notSpace)
+        return p + std::countr_zero(notSpace);
+    }
+    return skipWhitespaceSse2(p, end);
+  }
+
+  TARGET_AVX2 static const char* skipIdentifierAvx2(const char* p, const char* end)
+  {
+    for (; end - p >= 32; p += 32)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i*)p);
+      __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+      __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+      __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+      __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+
+      uint32_t notIdentifier = ~uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), underscore)));
+      if (notIdentifier)
+        return p + std::countr_zero(notIdentifier);
+    }
+    return skipIdentifierSse2(p, end);
+  }
+
+  TARGET_AVX2 static const char* findNewlineAvx2(const char* p, const char* end)
+  {
+    for (; end - p >= 32; p += 32)
+    {
+      uint32_t found = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), _mm256_set1_epi8('\n'))));
+      if (found)
+        return p + std::countr_zero(found);
+    }
+    return findNewlineSse2(p, end);
+  }
+
+  TARGET_AVX2 static const char* findStringSpecialAvx2(const char* p, const char* end)
+  {
+    for (; end - p >= 32; p += 32)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i*)p);
+      __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+      uint32_t found = uint32_t(_mm256_movemask_epi8(special));
+      if (found)
+        return p + std::countr_zero(found);
+    }
+    return findStringSpecialSse2(p, end);
+  }
+#endif
+
+  struct Kernels
+  {
+    Implementation implementation;
+    const char* (*skipWhitespace)(const char*, const char*);
+    const char* (*skipIdentifier)(const char*, const char*);
+    const char* (*findNewline)(const char*, const char*);
+    const char* (*findStringSpecial)(const char*, const char*);
+  };
+
+  static Kernels getKernels(Implementation implementation)
+  {
+    switch (implementation)
+    {
+      case Implementation::Scalar:
+        return {implementation, skipWhitespaceScalar, skipIdentifierScalar, findNewlineScalar, findStringSpecialScalar};
+      case Implementation::Sse2:
+#ifdef WLANG_SCAN_SSE2
+        return {implementation, skipWhitespaceSse2, skipIdentifierSse2, findNewlineSse2, findStringSpecialSse2};
+#else
+        break;
+#endif
+      case Implementation::Avx2:
+#ifdef WLANG_SCAN_AVX2
+        return {implementation, skipWhitespaceAvx2, skipIdentifierAvx2, findNewlineAvx2, findStringSpecialAvx2};
+#else
+        break;
+#endif
+    }
+    message_and_abort("scan implementation not supported");
+  }
+
+  Implementation getBestImplementation()
+  {
+#ifdef WLANG_SCAN_AVX2
+    __builtin_cpu_init(); // we can be called during static initialisation, before it's been done for us
+    if (__builtin_cpu_supports("avx2"))
+      return Implementation::Avx2;
+#endif
+#ifdef WLANG_SCAN_SSE2
+    return Implementation::Sse2;
+#else
+    return Implementation::Scalar;
+#endif
+  }
+
+  Implementation getDefaultImplementation()
+  {
+    // AVX2 measured no faster than SSE2 on either benchmark input, and SSE2 is always there on x86_64
+    return std::min(getBestImplementation(), Implementation::Sse2);
+  }
+
+  static Kernels kernels = getKernels(getDefaultImplementation());
+
+  const char* skipWhitespace(const char* p, const char* end) { return kernels.skipWhitespace(p, end); }
+  const char* skipIdentifier(const char* p, const char* end) { return kernels.skipIdentifier(p, end); }
+  const char* findNewline(const char* p, const char* end) { return kernels.findNewline(p, end); }
+  const char* findStringSpecial(const char* p, const char* end) { return kernels.findStringSpecial(p, end); }
+
+  Implementation getImplementation() { return kernels.implementation; }
+
+  void setImplementation(Implementation implementation)
+  {
+    release_assert(implementation <= getBestImplementation());
+    kernels = getKernels(implementation);
+  }
+
+  const char* getImplementationName(Implementation implementation)
+  {
+    switch (implementation)
+    {
+      case Implementation::Scalar: return "scalar";
+      case Implementation::Sse2: return "sse2";
+      case Implementation::Avx2: return "avx2";
+    }
+    return "";
+  }
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// Vectorised inner loops for the tokeniser. Each one scans forward from p and returns the first position in [p, end)
+// that stops the scan, or end. The implementation is picked at startup, see getDefaultImplementation().
+namespace Scan
+{
+  // Skips spaces, tabs, carriage returns and newlines
+  const char* skipWhitespace(const char* p, const char* end);
+
+  // Skips [A-Za-z0-9_]
+  const char* skipIdentifier(const char* p, const char* end);
+
+  // Finds the first '\n', the end of a comment
+  const char* findNewline(const char* p, const char* end);
+
+  // Finds the first '"' or '\\', the next thing inside a string literal that needs looking at
+  const char* findStringSpecial(const char* p, const char* end);
+
+  enum class Implementation
+  {
+    Scalar,
+    Sse2,
+    Avx2,
+  };
+
+  Implementation getBestImplementation(); // the widest one this cpu supports
+  Implementation getDefaultImplementation(); // what we start with, SSE2 where there is one
+  Implementation getImplementation();
+  void setImplementation(Implementation implementation); // for benchmarks, must be supported by the cpu
+  const char* getImplementationName(Implementation implementation);
+}
\ No newline at end of file
@@ -0,0 +1,256 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Common/Assert.hpp"
+#include "Symbol.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define WLANG_SCOPE_TABLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Maps the names declared in one scope to what they refer to. Most scopes only declare a couple of names, so the
+// first few are kept inline in the table itself and found with a linear scan, without allocating anything. Bigger
+// scopes (like the link scope, with every global in the program) switch to an open addressing table. Each slot there
+// has a control byte holding 7 bits of its key's hash, or empty, and lookups compare a whole group of 16 control
+// bytes at once before looking at any keys.
+template<typename T> class ScopeTable
+{
+  static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+public:
+  ScopeTable() = default;
+  ScopeTable(const ScopeTable&) = delete;
+  ScopeTable& operator=(const ScopeTable&) = delete;
+  ~ScopeTable() { this->freeLarge(); }
+
+  uint32_t size() const { return this->count; }
+  bool empty() const { return this->count == 0; }
+
+  T* get(Symbol key)
+  {
+    if (this->capacity == 0)
+    {
+      for (uint32_t i = 0; i < this->count; i++)
+      {
+        if (this->storage.small.keys[i] == key)
+          return &this->storage.small.values[i];
+      }
+      return nullptr;
+    }
+
+    int64_t slot = this->findLarge(key);
+    return slot < 0 ? nullptr : &this->storage.large.entries[slot].value;
+  }
+
+  const T* get(Symbol key) const { return const_cast<ScopeTable*>(this)->get(key); }
+
+  T& at(Symbol key)
+  {
+    T* value = this->get(key);
+    release_assert(value);
+    return *value;
+  }
+
+  // Adds the key, or replaces its value if it's already there
+  void set(Symbol key, const T& value)
+  {
+    if (T* existing = this->get(key))
+      *existing = value;
+    else
+      this->add(key, value);
+  }
+
+  // Adds the key, unless it's already there. Returns false if it was.
+  bool insert(Symbol key, const T& value)
+  {
+    if (this->get(key))
+      return false;
+    this->add(key, value);
+    return true;
+  }
+
+  void clear()
+  {
+    this->freeLarge();
+    this->count = 0;
+  }
+
+  // Calls func(Symbol, const T&) for every entry, in no particular order
+  template<typename Func> void forEach(Func&& func) const
+  {
+    if (this->capacity == 0)
+    {
+      for (uint32_t i = 0; i < this->count; i++)
+        func(this->storage.small.keys[i], this->storage.small.values[i]);
+      return;
+    }
+
+    for (uint32_t slot = 0; slot < this->capacity; slot++)
+    {
+      if (this->storage.large.control[slot] != emptyControl)
+        func(this->storage.large.entries[slot].key, this->storage.large.entries[slot].value);
+    }
+  }
+
+  // Removes every entry where predicate(Symbol, const T&) returns true
+  template<typename Predicate> void removeIf(Predicate&& predicate)
+  {
+    std::vector<std::pair<Symbol, T>> kept;
+    this->forEach([&](Symbol key, const T& value)
+    {
+      if (!predicate(key, value))
+        kept.emplace_back(key, value);
+    });
+
+    this->clear();
+    for (const auto& [key, value] : kept)
+      this->add(key, value);
+  }
+
+private:
+  static constexpr uint32_t inlineCapacity = 4;
+  static constexpr uint32_t groupSize = 16;
+  static constexpr uint32_t firstLargeCapacity = groupSize * 2;
+  static constexpr uint8_t emptyControl = 0x80;
+
+  // Symbol ids are (index in shard << 4 | shard) + 1, so id / groupSize is the index within the id's interning shard.
+  // Shards fill at about the same rate, so names interned around the same time (like the globals in one file) have
+  // similar indices, and the i-th name of each of the 16 shards share a group of 16 slots. Those names then stay near
+  // each other in the table, which measured faster than spreading them with a hash. The tag is taken from a proper
+  // hash instead, since names in a group only differ in the shard bits.
+  uint32_t getFirstGroup(Symbol key) const { return (key.getId() / groupSize) & (this->capacity / groupSize - 1); }
+  static uint8_t getTag(Symbol key) { return uint8_t((uint64_t(key.getId()) * 0x9E3779B97F4A7C15ULL) >> 57); } // never emptyControl
+
+  // A bit set for each control byte in the group that equals value
+  static uint32_t matchGroup(const uint8_t* group, uint8_t value)
+  {
+#ifdef WLANG_SCOPE_TABLE_SSE2
+    __m128i control = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+    return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(char(value)))));
+#else
+    uint32_t matches = 0;
+    for (uint32_t i = 0; i < groupSize; i++)
+      matches |= uint32_t(group[i] == value) << i;
+    return matches;
+#endif
+  }
+
+  int64_t findLarge(Symbol key) const
+  {
+    uint8_t tag = getTag(key);
+    uint32_t groupMask = this->capacity / groupSize - 1;
+
+    // There is always at least one empty slot, so this will stop
+    for (uint32_t group = this->getFirstGroup(key);; group = (group + 1) & groupMask)
+    {
+      const uint8_t* control = this->storage.large.control + group * groupSize;
+      for (uint32_t matches = matchGroup(control, tag); matches; matches &= matches - 1)
+      {
+        uint32_t slot = group * groupSize + uint32_t(std::countr_zero(matches));
+        if (this->storage.large.entries[slot].key == key)
+          return slot;
+      }
+
+      if (matchGroup(control, emptyControl))
+        return -1;
+    }
+  }
+
+  // key must not be in the table already
+  void add(Symbol key, const T& value)
+  {
+    if (this->capacity == 0 && this->count < inlineCapacity)
+    {
+      this->storage.small.keys[this->count] = key;
+      this->storage.small.values[this->count] = value;
+      this->count++;
+      return;
+    }
+
+    // keep the load factor at or under 7/8
+    if (this->capacity == 0 || (this->count + 1) * 8 > this->capacity * 7)
+      this->grow();
+
+    uint32_t groupMask = this->capacity / groupSize - 1;
+    for (uint32_t group = this->getFirstGroup(key);; group = (group + 1) & groupMask)
+    {
+      uint8_t* control = this->storage.large.control + group * groupSize;
+      uint32_t empties = matchGroup(control, emptyControl);
+      if (empties)
+      {
+        uint32_t slot = group * groupSize + uint32_t(std::countr_zero(empties));
+        this->storage.large.control[slot] = getTag(key);
+        this->storage.large.entries[slot] = Entry { .key = key, .value = value };
+        this->count++;
+        return;
+      }
+    }
+  }
+
+  void grow()
+  {
+    std::vector<std::pair<Symbol, T>> entries;
+    entries.reserve(this->count);
+    this->forEach([&](Symbol key, const T& value) { entries.emplace_back(key, value); });
+
+    uint32_t newCapacity = this->capacity == 0 ? firstLargeCapacity : this->capacity * 2;
+    release_assert(newCapacity > this->capacity);
+    this->clear();
+
+    // One allocation for both arrays. Capacity is a multiple of 16, so the entries start 16 byte aligned.
+    uint8_t* block = new uint8_t[size_t(newCapacity) * (1 + sizeof(Entry))];
+    this->capacity = newCapacity;
+    this->storage.large.control = block;
+    this->storage.large.entries = reinterpret_cast<Entry*>(block + newCapacity);
+    std::fill(block, block + newCapacity, emptyControl);
+
+    for (const auto& [key, value] : entries)
+      this->add(key, value);
+  }
+
+  void freeLarge()
+  {
+    if (this->capacity == 0)
+      return;
+
+    delete[] this->storage.large.control;
+    this->storage.small = Small();
+    this->capacity = 0;
+  }
+
+  struct Small
+  {
+    Symbol keys[inlineCapacity];
+    T values[inlineCapacity];
+  };
+
+  // Keys and values are kept together, so a hit only touches the control bytes and one entry
+  struct Entry
+  {
+    Symbol key;
+    T value;
+  };
+
+  struct Large
+  {
+    uint8_t* control;
+    Entry* entries;
+  };
+
+  union Storage
+  {
+    Small small;
+    Large large;
+
+    Storage() : small() {}
+  };
+
+  uint32_t count = 0;
+  uint32_t capacity = 0; // of the large table, or 0 while everything fits inline
+  Storage storage;
+};
\ No newline at end of file
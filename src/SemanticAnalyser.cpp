@@ -4,13 +4,14 @@
 
 void SemanticAnalyser::run(MergedAst& ast)
 {
-  this->linkScope = &ast.linkScope;
-
-  for (AstChunk* chunk : ast)
-    resolveScopeIds(chunk->root);
+  resolveScopeIds(ast);
 
   for (AstChunk* chunk : ast)
+  {
+    this->currentChunk = chunk;
     run(chunk->root);
+  }
+  this->currentChunk = nullptr;
 }
 
 void SemanticAnalyser::run(Root* root)
@@ -26,14 +27,14 @@ void SemanticAnalyser::run(Root* root)
 void SemanticAnalyser::run(Func* func)
 {
   if (!func->external)
-    run(func->funcBody, func);
+    run(get(func->funcBody), func);
 }
 
 void SemanticAnalyser::run(Block* block, Func* func)
 {
   this->scopeStack.emplace_back(block->scope);
-  for (Statement* statement : block->statements)
-    run(statement, func);
+  for (NodeRef<Statement> statement : block->statements)
+    run(get(statement), func);
   this->scopeStack.resize(this->scopeStack.size()-1);
 }
 
@@ -52,19 +53,19 @@ void SemanticAnalyser::run(Statement* statement, Func* func)
   switch (statement->tag())
   {
     case Statement::Tag::Return:
-      run(statement->returnStatment(), func);
+      run(get(statement->returnStatment()), func);
       break;
     case Statement::Tag::Variable:
       run(statement->variable());
       break;
     case Statement::Tag::Assignment:
-      run(statement->assignment());
+      run(get(statement->assignment()));
       break;
     case Statement::Tag::Expression:
-      run(statement->expression());
+      run(get(statement->expression()));
       break;
     case Statement::Tag::IfElseChain:
-      run(statement->ifElseChain(), func);
+      run(get(statement->ifElseChain()), func);
       break;
     case Statement::Tag::None:
       message_and_abort("bad statement");
@@ -73,9 +74,11 @@ void SemanticAnalyser::run(Statement* statement, Func* func)
 
 void SemanticAnalyser::run(Assignment* assignment)
 {
-  run(assignment->left);
-  run(assignment->right);
-  release_assert(this->canAssign(assignment->left->type, assignment->right->type));
+  Expression* left = get(assignment->left);
+  Expression* right = get(assignment->right);
+  run(left);
+  run(right);
+  release_assert(this->canAssign(left->type, right->type));
 }
 
 void SemanticAnalyser::run(Expression* expression)
@@ -87,10 +90,13 @@ void SemanticAnalyser::run(Expression* expression)
       VariableDeclaration* var = expression->val.id().resolved.variableDeclaration();
       if (!expression->source.isAfterEndOf(var->source))
       {
+        const LineTable& lines = this->currentChunk->getLineTable();
+        LineTable::LineColumn used = lines.get(expression->source.start);
+        LineTable::LineColumn defined = lines.get(var->source.start);
         message_and_abort_fmt("%s (%d:%d) used before definition (%d:%d)",
-                              expression->val.id().str.c_str(),
-                              expression->source.start.y, expression->source.start.x,
-                              var->source.start.y, var->source.start.x);
+                              std::string(expression->val.id().name.str()).c_str(),
+                              used.line, used.column,
+                              defined.line, defined.column);
       }
 
       expression->type = var->type;
@@ -105,7 +111,7 @@ void SemanticAnalyser::run(Expression* expression)
 
     case Expression::Val::Tag::StringConstant:
     {
-      expression->type = this->linkScope->types.at("string").item->reference();
+      expression->type = this->linkScope->types.at(Symbol("string")).item->reference();
       break;
     }
 
@@ -123,7 +129,7 @@ void SemanticAnalyser::run(Expression* expression)
 
     case Expression::Val::Tag::Op:
     {
-      Op* op = expression->val.op();
+      Op* op = get(expression->val.op());
       switch (op->type)
       {
         case Op::Type::CompareEqual:
@@ -131,17 +137,18 @@ void SemanticAnalyser::run(Expression* expression)
         case Op::Type::LogicalAnd:
         case Op::Type::LogicalOr:
         {
-          Op::Binary& binary = op->args.binary();
-          run(binary.left);
-          run(binary.right);
-          canCompare(binary.left->type, binary.right->type);
+          Expression* left = get(op->args.binary().left);
+          Expression* right = get(op->args.binary().right);
+          run(left);
+          run(right);
+          canCompare(left->type, right->type);
           expression->type = BuiltinTypes::inst.tBool.reference();
           break;
         }
 
         case Op::Type::LogicalNot:
         {
-          Expression* arg = op->args.unary().expression;
+          Expression* arg = get(op->args.unary().expression);
           run(arg);
           release_assert(arg->type.pointerDepth > 0 ||
                          arg->type.id.resolved.type() == &BuiltinTypes::inst.tBool ||
@@ -152,7 +159,7 @@ void SemanticAnalyser::run(Expression* expression)
 
         case Op::Type::UnaryMinus:
         {
-          Expression* arg = op->args.unary().expression;
+          Expression* arg = get(op->args.unary().expression);
           run(arg);
           release_assert(arg->type.pointerDepth == 0 && arg->type.id.resolved.type()->builtinNumeric);
           expression->type = arg->type;
@@ -161,7 +168,7 @@ void SemanticAnalyser::run(Expression* expression)
 
         case Op::Type::AddressOf:
         {
-          Expression* arg = op->args.unary().expression;
+          Expression* arg = get(op->args.unary().expression);
           run(arg);
           expression->type = arg->type;
           expression->type.pointerDepth++;
@@ -171,31 +178,33 @@ void SemanticAnalyser::run(Expression* expression)
         case Op::Type::Call:
         {
           Op::Call& callData = op->args.call();
+          Expression* callable = get(callData.callable);
 
           Func* function = nullptr;
-          if (callData.callable->val.isId()) // free function
+          if (callable->val.isId()) // free function
           {
-            function = callData.callable->val.id().resolved.function();
+            function = callable->val.id().resolved.function();
             release_assert(callData.callArgs.size() == function->args.size());
 
             for (int32_t i = 0; i < int32_t(callData.callArgs.size()); i++)
             {
-              run(callData.callArgs[i]);
-              release_assert(callData.callArgs[i]->type == function->args[i]->type);
+              Expression* arg = get(callData.callArgs[i]);
+              run(arg);
+              release_assert(arg->type == function->args[i]->type);
             }
           }
           else // member call
           {
-            release_assert(callData.callable->val.isOp());
-            Op* callOp = callData.callable->val.op();
+            release_assert(callable->val.isOp());
+            Op* callOp = get(callable->val.op());
             release_assert(callOp->type == Op::Type::MemberAccess);
-            Expression* object = callOp->args.memberAccess().expression;
+            Expression* object = get(callOp->args.memberAccess().expression);
             run(object);
 
             if (object->type.id.resolved.type()->builtin)
             {
               // can ignore "constructor calls" on builtin types
-              release_assert(callOp->args.memberAccess().member.str == "defaultConstruct");
+              release_assert(callOp->args.memberAccess().member.name == Symbol("defaultConstruct"));
               expression->type = BuiltinTypes::inst.tI32.reference();
               break;
             }
@@ -208,8 +217,9 @@ void SemanticAnalyser::run(Expression* expression)
 
             for (int32_t i = 1; i < int32_t(callData.callArgs.size()); i++)
             {
-              run(callData.callArgs[i-1]);
-              release_assert(callData.callArgs[i-1]->type == function->args[i]->type);
+              Expression* arg = get(callData.callArgs[i-1]);
+              run(arg);
+              release_assert(arg->type == function->args[i]->type);
             }
           }
 
@@ -221,12 +231,13 @@ void SemanticAnalyser::run(Expression* expression)
 
         case Op::Type::Subscript:
         {
-          Op::Subscript& subscript = op->args.subscript();
-          run(subscript.item);
-          release_assert(subscript.item->type.pointerDepth > 0);
-          run(subscript.index);
-          release_assert(subscript.index->type.pointerDepth == 0 && subscript.index->type.id.resolved.type()->builtinNumeric);
-          expression->type = subscript.item->type;
+          Expression* item = get(op->args.subscript().item);
+          Expression* index = get(op->args.subscript().index);
+          run(item);
+          release_assert(item->type.pointerDepth > 0);
+          run(index);
+          release_assert(index->type.pointerDepth == 0 && index->type.id.resolved.type()->builtinNumeric);
+          expression->type = item->type;
           expression->type.pointerDepth--;
           break;
         }
@@ -234,13 +245,14 @@ void SemanticAnalyser::run(Expression* expression)
         case Op::Type::MemberAccess:
         {
           Op::MemberAccess& memberAccess = op->args.memberAccess();
-          run(memberAccess.expression);
-          release_assert(memberAccess.expression->type.pointerDepth <= 1);
-          release_assert(memberAccess.expression->type.id.resolved.type()->typeClass);
+          Expression* object = get(memberAccess.expression);
+          run(object);
+          release_assert(object->type.pointerDepth <= 1);
+          release_assert(object->type.id.resolved.type()->typeClass);
 
           // As an exception, we resolve this here, as it depends on fetching the scope of the actual type, which is not available during
           // the normal resolveScopeIds pass.
-          memberAccess.member.resolveVariableDeclaration(*memberAccess.expression->type.id.resolved.type()->typeClass->memberScope);
+          memberAccess.member.resolveVariableDeclaration(*object->type.id.resolved.type()->typeClass->memberScope);
           release_assert(memberAccess.member.resolved.variableDeclaration());
 
           expression->type = memberAccess.member.resolved.variableDeclaration()->type;
@@ -252,12 +264,13 @@ void SemanticAnalyser::run(Expression* expression)
         case Op::Type::Multiply:
         case Op::Type::Divide:
         {
-          Op::Binary& binary = op->args.binary();
-          run(binary.left);
-          run(binary.right);
-          release_assert(binary.left->type.pointerDepth == 0 && binary.left->type.id.resolved.type()->builtinNumeric);
-          release_assert(binary.right->type.pointerDepth == 0 && binary.right->type.id.resolved.type()->builtinNumeric);
-          expression->type = BuiltinTypes::resolveBinaryOperatorPromotion(binary.left->type.id.resolved.type(), binary.right->type.id.resolved.type())->reference();
+          Expression* left = get(op->args.binary().left);
+          Expression* right = get(op->args.binary().right);
+          run(left);
+          run(right);
+          release_assert(left->type.pointerDepth == 0 && left->type.id.resolved.type()->builtinNumeric);
+          release_assert(right->type.pointerDepth == 0 && right->type.id.resolved.type()->builtinNumeric);
+          expression->type = BuiltinTypes::resolveBinaryOperatorPromotion(left->type.id.resolved.type(), right->type.id.resolved.type())->reference();
           break;
         }
         case Op::Type::ENUM_END:
@@ -277,35 +290,50 @@ void SemanticAnalyser::run(VariableDeclaration* variableDeclaration)
 {
   if (variableDeclaration->initialiser)
   {
-    run(variableDeclaration->initialiser);
-    release_assert(this->canAssign(variableDeclaration->type, variableDeclaration->initialiser->type));
+    Expression* initialiser = get(variableDeclaration->initialiser);
+    run(initialiser);
+    release_assert(this->canAssign(variableDeclaration->type, initialiser->type));
   }
 }
 
 void SemanticAnalyser::run(ReturnStatement* returnStatement, Func* func)
 {
-  run(returnStatement->retval);
-  release_assert(returnStatement->retval->type == func->returnType);
+  Expression* retval = get(returnStatement->retval);
+  run(retval);
+  release_assert(retval->type == func->returnType);
 }
 
 void SemanticAnalyser::run(IfElseChain* ifElseChain, Func* func)
 {
   for (int32_t i = 0; i < int32_t(ifElseChain->items.size()); i++)
   {
-    IfElseChainItem* item = ifElseChain->items[i];
+    IfElseChainItem* item = get(ifElseChain->items[i]);
 
     if (item->condition)
     {
-      run(item->condition);
-      release_assert(item->condition->type == BuiltinTypes::inst.tBool.reference());
+      Expression* condition = get(item->condition);
+      run(condition);
+      release_assert(condition->type == BuiltinTypes::inst.tBool.reference());
     }
     else
     {
       release_assert(ifElseChain->items.size() > 1 && i == int32_t(ifElseChain->items.size()) - 1);
     }
 
-    run(item->block, func);
+    run(get(item->block), func);
+  }
+}
+
+void SemanticAnalyser::resolveScopeIds(MergedAst& ast)
+{
+  this->linkScope = &ast.linkScope;
+
+  for (AstChunk* chunk : ast)
+  {
+    this->currentChunk = chunk;
+    resolveScopeIds(chunk->root);
   }
+  this->currentChunk = nullptr;
 }
 
 void SemanticAnalyser::resolveScopeIds(Root* root)
@@ -321,7 +349,7 @@ void SemanticAnalyser::resolveScopeIds(Root* root)
   for (Func* func : root->funcList->functions)
   {
     if (!func->external)
-      resolveScopeIds(func->funcBody);
+      resolveScopeIds(get(func->funcBody));
   }
 
   this->scopeStack.resize(this->scopeStack.size()-1);
@@ -343,8 +371,8 @@ void SemanticAnalyser::resolveScopeIds(Func* func)
 void SemanticAnalyser::resolveScopeIds(Block* block)
 {
   this->scopeStack.emplace_back(block->scope);
-  for (Statement* statement : block->statements)
-    resolveScopeIds(statement);
+  for (NodeRef<Statement> statement : block->statements)
+    resolveScopeIds(get(statement));
   this->scopeStack.resize(this->scopeStack.size()-1);
 }
 
@@ -353,19 +381,19 @@ void SemanticAnalyser::resolveScopeIds(Statement* statement)
   switch (statement->tag())
   {
     case Statement::Tag::Return:
-      resolveScopeIds(statement->returnStatment());
+      resolveScopeIds(get(statement->returnStatment()));
       break;
     case Statement::Tag::Variable:
       resolveScopeIds(statement->variable());
       break;
     case Statement::Tag::Assignment:
-      resolveScopeIds(statement->assignment());
+      resolveScopeIds(get(statement->assignment()));
       break;
     case Statement::Tag::Expression:
-      resolveScopeIds(statement->expression());
+      resolveScopeIds(get(statement->expression()));
       break;
     case Statement::Tag::IfElseChain:
-      resolveScopeIds(statement->ifElseChain());
+      resolveScopeIds(get(statement->ifElseChain()));
       break;
     case Statement::Tag::None:
       message_and_abort("bad statement");
@@ -376,9 +404,9 @@ void SemanticAnalyser::resolveScopeIds(IfElseChain* ifElseChain)
 {
   for (int32_t i = 0; i < int32_t(ifElseChain->items.size()); i++)
   {
-    IfElseChainItem* item = ifElseChain->items[i];
-    resolveScopeIds(item->condition);
-    resolveScopeIds(item->block);
+    IfElseChainItem* item = get(ifElseChain->items[i]);
+    resolveScopeIds(get(item->condition));
+    resolveScopeIds(get(item->block));
   }
 }
 
@@ -386,7 +414,7 @@ void SemanticAnalyser::resolveScopeIds(VariableDeclaration* variableDeclaration)
 {
   resolveScopeIds(variableDeclaration->type);
   if (variableDeclaration->initialiser)
-    resolveScopeIds(variableDeclaration->initialiser);
+    resolveScopeIds(get(variableDeclaration->initialiser));
 }
 
 void SemanticAnalyser::resolveScopeIds(TypeRef& typeRef)
@@ -414,7 +442,7 @@ void SemanticAnalyser::resolveScopeIds(Expression* expression)
 
     case Expression::Val::Tag::Op:
     {
-      Op* op = expression->val.op();
+      Op* op = get(expression->val.op());
       switch (op->type)
       {
         case Op::Type::CompareEqual:
@@ -427,8 +455,8 @@ void SemanticAnalyser::resolveScopeIds(Expression* expression)
         case Op::Type::Divide:
         {
           Op::Binary& binary = op->args.binary();
-          resolveScopeIds(binary.left);
-          resolveScopeIds(binary.right);
+          resolveScopeIds(get(binary.left));
+          resolveScopeIds(get(binary.right));
           break;
         }
 
@@ -436,42 +464,43 @@ void SemanticAnalyser::resolveScopeIds(Expression* expression)
         case Op::Type::LogicalNot:
         case Op::Type::AddressOf:
         {
-          resolveScopeIds(op->args.unary().expression);
+          resolveScopeIds(get(op->args.unary().expression));
           break;
         }
 
         case Op::Type::Call:
         {
           Op::Call& call = op->args.call();
-          if (call.callable->val.isId())
+          Expression* callable = get(call.callable);
+          if (callable->val.isId())
           {
-            call.callable->val.id().resolveFunction(*scopeStack.back());
-            release_assert(call.callable->val.id().resolved.function());
+            callable->val.id().resolveFunction(*scopeStack.back());
+            release_assert(callable->val.id().resolved.function());
           }
           else
           {
-            release_assert(call.callable->val.isOp() && call.callable->val.op()->type == Op::Type::MemberAccess);
-            resolveScopeIds(call.callable->val.op()->args.memberAccess().expression);
+            release_assert(callable->val.isOp() && get(callable->val.op())->type == Op::Type::MemberAccess);
+            resolveScopeIds(get(get(callable->val.op())->args.memberAccess().expression));
             // Cannot resolve the member function name yet, see case Op::Type::MemberAccess below
           }
 
           for (int32_t i = 0; i < int32_t(call.callArgs.size()); i++)
-            resolveScopeIds(call.callArgs[i]);
+            resolveScopeIds(get(call.callArgs[i]));
           break;
         }
 
         case Op::Type::Subscript:
         {
           Op::Subscript& subscript = op->args.subscript();
-          resolveScopeIds(subscript.item);
-          resolveScopeIds(subscript.index);
+          resolveScopeIds(get(subscript.item));
+          resolveScopeIds(get(subscript.index));
           break;
         }
 
         case Op::Type::MemberAccess:
         {
           Op::MemberAccess& memberAccess = op->args.memberAccess();
-          resolveScopeIds(memberAccess.expression);
+          resolveScopeIds(get(memberAccess.expression));
           // Cannot resolve the member name yet, as it depends on the derived type of the MemberAccess::expression expression.
           // So, as an exception, this is deferred to the next pass.
           break;
@@ -491,13 +520,13 @@ void SemanticAnalyser::resolveScopeIds(Expression* expression)
 
 void SemanticAnalyser::resolveScopeIds(Assignment* assignment)
 {
-  resolveScopeIds(assignment->left);
-  resolveScopeIds(assignment->right);
+  resolveScopeIds(get(assignment->left));
+  resolveScopeIds(get(assignment->right));
 }
 
 void SemanticAnalyser::resolveScopeIds(ReturnStatement* returnStatement)
 {
-  resolveScopeIds(returnStatement->retval);
+  resolveScopeIds(get(returnStatement->retval));
 }
 
 bool SemanticAnalyser::canCompare(const TypeRef& left, const TypeRef& right)
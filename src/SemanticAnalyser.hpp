@@ -1,5 +1,6 @@
 #pragma once
 #include "Ast.hpp"
+#include "AstChunk.hpp"
 
 class MergedAst;
 
@@ -7,6 +8,7 @@ class SemanticAnalyser
 {
 public:
   void run(MergedAst& ast);
+  void resolveScopeIds(MergedAst& ast); // just the first pass of run, which binds every name to its declaration
 
 private:
   void run(Root* root);
@@ -35,7 +37,10 @@ private:
   bool canCompare(const TypeRef& left, const TypeRef& right);
   bool canAssign(const TypeRef& left, const TypeRef& right);
 
+  template<typename T> T* get(NodeRef<T> ref) { return this->currentChunk->get(ref); }
+
 private:
   std::vector<Scope*> scopeStack;
   Scope* linkScope = nullptr;
+  AstChunk* currentChunk = nullptr; // the one being walked, for looking up NodeRefs and for diagnostics
 };
\ No newline at end of file
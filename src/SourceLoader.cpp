@@ -0,0 +1,42 @@
+#include "SourceLoader.hpp"
+#include "Parallel.hpp"
+#include "Parser.hpp"
+#include "ClassDefaultsGenerator.hpp"
+#include "Common/Assert.hpp"
+#include <atomic>
+#include <thread>
+
+void loadSources(const std::vector<fs::path>& paths, int32_t threadCount, const std::function<void(std::unique_ptr<AstChunk>)>& consume)
+{
+  std::vector<std::unique_ptr<AstChunk>> chunks(paths.size());
+  std::vector<std::atomic_bool> ready(paths.size());
+
+  std::thread loader([&]()
+  {
+    bool loaded = parallelFor(int32_t(paths.size()), threadCount, [&](int32_t i)
+    {
+      std::unique_ptr<AstChunk> chunk = std::make_unique<AstChunk>();
+      chunk->path = paths[i].string();
+      if (!chunk->sourceFile.open(paths[i]))
+        message_and_abort_fmt("failed to read %s\n", chunk->path.c_str());
+      chunk->source = chunk->sourceFile.getContents();
+
+      parse(*chunk, chunk->source);
+      generateClassDefaults(*chunk);
+
+      chunks[i] = std::move(chunk);
+      ready[i] = true;
+      ready[i].notify_one();
+      return true;
+    });
+    release_assert(loaded);
+  });
+
+  for (size_t i = 0; i < paths.size(); i++)
+  {
+    ready[i].wait(false);
+    consume(std::move(chunks[i]));
+  }
+
+  loader.join();
+}
\ No newline at end of file
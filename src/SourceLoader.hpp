@@ -0,0 +1,9 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include "AstChunk.hpp"
+
+// Maps, tokenises, parses and generates class defaults for each path on up to threadCount worker threads. Chunks don't
+// share any state until they're linked, so this is all independent. consume is called on the calling thread with each
+// finished chunk in path order, so linking stays deterministic, and overlaps with the work on the files after it.
+void loadSources(const std::vector<fs::path>& paths, int32_t threadCount, const std::function<void(std::unique_ptr<AstChunk>)>& consume);
\ No newline at end of file
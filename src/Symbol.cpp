@@ -0,0 +1,130 @@
+#include "Symbol.hpp"
+#include "Arena.hpp"
+#include "Common/Assert.hpp"
+#include "Common/Hash.hpp"
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+  // The interner is split into shards by hash, each with its own lock, so threads parsing different files rarely
+  // wait on each other. Ids encode their shard in the low bits, and their index in that shard above it.
+  constexpr uint32_t shardBits = 4;
+  constexpr uint32_t shardCount = 1 << shardBits;
+  constexpr uint32_t maxPerShard = (UINT32_MAX >> shardBits) - 1;
+
+  // Strings are found by id through a list of segments, each twice the size of the one before. Segments are never
+  // moved or freed, so str() can read them without taking the lock.
+  constexpr uint32_t firstSegmentSize = 1024;
+  constexpr uint32_t segmentCount = 32 - shardBits - 10 + 1;
+
+  struct Slot
+  {
+    uint32_t hash = 0;
+    uint32_t id = 0; // 0 means the slot is free
+  };
+
+  struct Shard
+  {
+    std::mutex mutex;
+    Arena strings;
+    std::vector<Slot> table; // open addressing, linear probing, always a power of two in size
+    uint32_t count = 0;
+    std::string_view* segments[segmentCount] = {};
+
+    std::string_view& get(uint32_t index)
+    {
+      uint32_t segment = std::bit_width(index / firstSegmentSize + 1) - 1;
+      uint32_t segmentStart = firstSegmentSize * ((1u << segment) - 1);
+      return this->segments[segment][index - segmentStart];
+    }
+
+    uint32_t add(std::string_view str, uint32_t shardIndex)
+    {
+      release_assert(this->count < maxPerShard);
+      uint32_t index = this->count++;
+
+      uint32_t segment = std::bit_width(index / firstSegmentSize + 1) - 1;
+      if (!this->segments[segment])
+      {
+        size_t size = size_t(firstSegmentSize) << segment;
+        this->segments[segment] = static_cast<std::string_view*>(this->strings.allocate(sizeof(std::string_view) * size, alignof(std::string_view)));
+      }
+
+      char* data = static_cast<char*>(this->strings.allocate(str.size(), 1));
+      memcpy(data, str.data(), str.size());
+      this->get(index) = std::string_view(data, str.size());
+
+      return ((index << shardBits) | shardIndex) + 1;
+    }
+
+    void grow()
+    {
+      std::vector<Slot> newTable(this->table.empty() ? 1024 : this->table.size() * 2);
+      size_t mask = newTable.size() - 1;
+      for (const Slot& slot : this->table)
+      {
+        if (!slot.id)
+          continue;
+
+        size_t i = slot.hash & mask;
+        while (newTable[i].id)
+          i = (i + 1) & mask;
+        newTable[i] = slot;
+      }
+      this->table = std::move(newTable);
+    }
+  };
+
+  // Function local, so it's usable from other statics' constructors (eg BuiltinTypes)
+  Shard* getShards()
+  {
+    static Shard shards[shardCount];
+    return shards;
+  }
+}
+
+Symbol::Symbol(std::string_view str)
+{
+  if (str.empty())
+    return;
+
+  uint64_t hash = hashString(str);
+  uint32_t shardIndex = uint32_t(hash & (shardCount - 1));
+  uint32_t slotHash = uint32_t(hash >> 32);
+  Shard& shard = getShards()[shardIndex];
+
+  std::scoped_lock lock(shard.mutex);
+
+  if ((shard.count + 1) * 2 > shard.table.size())
+    shard.grow();
+
+  size_t mask = shard.table.size() - 1;
+  for (size_t i = slotHash & mask;; i = (i + 1) & mask)
+  {
+    Slot& slot = shard.table[i];
+    if (!slot.id)
+    {
+      slot = Slot { .hash = slotHash, .id = shard.add(str, shardIndex) };
+      this->id = slot.id;
+      return;
+    }
+
+    if (slot.hash == slotHash && shard.get((slot.id - 1) >> shardBits) == str)
+    {
+      this->id = slot.id;
+      return;
+    }
+  }
+}
+
+std::string_view Symbol::str() const
+{
+  if (!this->id)
+    return {};
+
+  uint32_t value = this->id - 1;
+  return getShards()[value & (shardCount - 1)].get(value >> shardBits);
+}
\ No newline at end of file
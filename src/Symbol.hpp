@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+// An interned string. Every distinct string gets one 32 bit id for the lifetime of the process, so comparing and
+// hashing symbols is just comparing and hashing integers. Interning is thread safe, and so is str(), which never
+// takes a lock. Id 0 is always the empty string, so a default constructed Symbol is empty.
+class Symbol
+{
+public:
+  Symbol() = default;
+  explicit Symbol(std::string_view str);
+
+  std::string_view str() const;
+  uint32_t getId() const { return this->id; }
+  bool empty() const { return this->id == 0; }
+
+  bool operator==(const Symbol& other) const { return this->id == other.id; }
+  bool operator!=(const Symbol& other) const { return this->id != other.id; }
+
+private:
+  uint32_t id = 0;
+};
+
+template<> struct std::hash<Symbol>
+{
+  size_t operator()(Symbol symbol) const { return symbol.getId(); }
+};
+
+template<typename T>
+using SymbolMap = std::unordered_map<Symbol, T>;
+
+using SymbolSet = std::unordered_set<Symbol>;
\ No newline at end of file
@@ -1,288 +1,278 @@
 #include "Tokeniser.hpp"
-#include "Common/StringUtil.hpp"
 #include "Common/Assert.hpp"
-#include <optional>
+#include "ScanKernels.hpp"
+#include <cstring>
 
-const std::vector<std::pair<std::string_view, Token::Type>> keywordMapping
+namespace
 {
-  {"return", Token::Type::Return},
-  {"extern", Token::Type::Extern},
-  {"class",  Token::Type::Class},
-  {"false",  Token::Type::False},
-  {"else",   Token::Type::Else},
-  {"true",   Token::Type::True},
-  {"null",   Token::Type::Null},
-  {"if",     Token::Type::If},
-};
-
-const std::vector<std::pair<std::string_view, Token::Type>> tokenMapping
-{
-  {"==", Token::Type::CompareEqual},
-  {"!=", Token::Type::CompareNotEqual},
-  {"&&", Token::Type::LogicalAnd},
-  {"||", Token::Type::LogicalOr},
-  {"!", Token::Type::LogicalNot},
-  {",", Token::Type::Comma},
-  {"(", Token::Type::OpenBracket},
-  {")", Token::Type::CloseBracket},
-  {"[", Token::Type::OpenSquareBracket},
-  {"]", Token::Type::CloseSquareBracket},
-  {"{", Token::Type::OpenBrace},
-  {"}", Token::Type::CloseBrace},
-  {";", Token::Type::Semicolon},
-  {"=", Token::Type::Assign},
-  {"+", Token::Type::Add},
-  {"-", Token::Type::Subtract},
-  {"*", Token::Type::Asterisk},
-  {"/", Token::Type::Divide},
-  {".", Token::Type::Dot},
-  {"&", Token::Type::Ampersand},
-};
-
-std::optional<int64_t> parseInteger(std::string_view str)
-{
-  // TODO: overflow check
-
-  int32_t value = 0;
-
-  for (char c : str)
-  {
-    if (Str::isNumeric(c))
-      value = value * 10 + (int32_t(c) - int32_t('0'));
-    else
-      return std::nullopt;
-  }
-
-  return value;
-}
-
-std::vector<Token> tokenise(std::string_view input)
-{
-  std::vector<Token> tokens;
-
-  enum class Type
+  // What a byte can start, so the main loop can dispatch on the first byte of each token with one table lookup
+  enum class CharClass : uint8_t
   {
-    Id,
-    Integer,
-    Comment,
-    String,
-    None,
+    Invalid,
+    Space,
+    IdStart,
+    Digit,
+    Quote,
+    Punctuation,
   };
 
-  Type accumulatorType = Type::None;
-  int32_t integerSize = -1;
-  bool escaped = false;
-  int32_t accumulatorStartY = -1;
-  int32_t accumulatorStartX = -1;
-  std::string accumulator;
-  accumulator.reserve(1024);
-
-  int32_t accumulatorY = 1;
-  int32_t accumulatorX = 1;
-  bool wasNewline = false;
-
-  auto breakToken = [&]()
+  struct CharTables
   {
-    if (accumulator.empty())
-      return;
-
-    SourceRange source({accumulatorStartX, accumulatorStartY}, {accumulatorX, accumulatorY});
+    CharClass classes[256] = {};
+    TokenType punctuation[256] = {}; // single byte tokens, two byte ones are special cased in scan()
 
-    if (accumulatorType == Type::Id)
-      tokens.emplace_back(Token{.type = Token::Type::Id, .idValue = accumulator, .source = source});
-    else if (accumulatorType == Type::Integer)
-      tokens.emplace_back(Token{.type = Token::Type::IntegerToken, .integerValue = {.val = *parseInteger(accumulator), .size = integerSize}, .source = source});
-    else if (accumulatorType == Type::String)
-      tokens.emplace_back(Token{.type = Token::Type::String, .stringValue = accumulator, .source = source});
-
-    accumulator.clear();
-    accumulatorType = Type::None;
-  };
-
-  auto accumulate = [&](char c)
-  {
-    if (accumulator.empty())
+    constexpr CharTables()
     {
-      accumulatorStartY = accumulatorY;
-      accumulatorStartX = accumulatorX;
+      for (int32_t c = 'a'; c <= 'z'; c++)
+        classes[c] = CharClass::IdStart;
+      for (int32_t c = 'A'; c <= 'Z'; c++)
+        classes[c] = CharClass::IdStart;
+      classes[uint8_t('_')] = CharClass::IdStart;
+      for (int32_t c = '0'; c <= '9'; c++)
+        classes[c] = CharClass::Digit;
+
+      classes[uint8_t(' ')] = CharClass::Space;
+      classes[uint8_t('\t')] = CharClass::Space;
+      classes[uint8_t('\r')] = CharClass::Space;
+      classes[uint8_t('\n')] = CharClass::Space;
+      classes[uint8_t('"')] = CharClass::Quote;
+
+      const std::pair<char, TokenType> singles[] =
+      {
+        {'!', TokenType::LogicalNot},
+        {',', TokenType::Comma},
+        {'(', TokenType::OpenBracket},
+        {')', TokenType::CloseBracket},
+        {'[', TokenType::OpenSquareBracket},
+        {']', TokenType::CloseSquareBracket},
+        {'{', TokenType::OpenBrace},
+        {'}', TokenType::CloseBrace},
+        {';', TokenType::Semicolon},
+        {'=', TokenType::Assign},
+        {'+', TokenType::Add},
+        {'-', TokenType::Subtract},
+        {'*', TokenType::Asterisk},
+        {'/', TokenType::Divide},
+        {'.', TokenType::Dot},
+        {'&', TokenType::Ampersand},
+        {'|', TokenType::LogicalOr}, // only valid doubled, checked in scan()
+      };
+
+      for (const auto& pair : singles)
+      {
+        classes[uint8_t(pair.first)] = CharClass::Punctuation;
+        punctuation[uint8_t(pair.first)] = pair.second;
+      }
     }
-    accumulator += c;
   };
 
-  auto advance = [&](size_t chars)
-  {
-    debug_assert(input.size() >= chars);
-    input = std::string_view(input.data() + chars, input.size() - chars);
-  };
+  constexpr CharTables charTables;
 
-  while (!input.empty())
+  bool isKeyword(std::string_view id, const char* keyword, size_t length)
   {
-    accumulatorX++;
+    return id.size() == length && memcmp(id.data(), keyword, length) == 0;
+  }
 
-    if (wasNewline)
+  // reads the digits and optional size suffix of an integer literal, returning the end of it
+  const char* readInteger(const char* p, const char* end, IntegerToken& result)
+  {
+    // TODO: overflow check
+    int64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
     {
-      accumulatorY++;
-      accumulatorX = 1;
-      wasNewline = false;
+      value = value * 10 + (*p - '0');
+      p++;
     }
 
-    if (input[0] == '\n')
-      wasNewline = true;
-
-    if (accumulatorType == Type::Comment)
+    int32_t size = 32; // default
+    std::string_view rest(p, end - p);
+    if (rest.starts_with("i64"))
     {
-      if (input[0] == '\n')
-        accumulatorType = Type::None;
-
-      advance(1);
-      continue;
+      size = 64;
+      p += 3;
     }
-
-    if (accumulatorType == Type::String)
+    else if (rest.starts_with("i32"))
     {
-      if (escaped)
-      {
-        escaped = false;
-      }
-      else
-      {
-        if (input[0] == '"')
-        {
-          accumulator += '"';
-          advance(1);
-          breakToken();
-          continue;
-        }
-
-        if (input[0] == '\\')
-          escaped = true;
-      }
-
-      accumulator += input[0];
-      advance(1);
-      continue;
+      size = 32;
+      p += 3;
     }
-
-    if (Str::isSpace(input[0]))
+    else if (rest.starts_with("i16"))
     {
-      breakToken();
-      advance(1);
-      continue;
+      size = 16;
+      p += 3;
     }
+    else if (rest.starts_with("i8"))
+    {
+      size = 8;
+      p += 2;
+    }
+
+    result = {.val = value, .size = size};
+    return p;
+  }
 
-    if (input.starts_with("//"))
+  TokenType getKeywordOrId(std::string_view id)
+  {
+    switch (id[0])
     {
-      breakToken();
-      accumulatorType = Type::Comment;
-      advance(2);
-      continue;
+      case 'c': return isKeyword(id, "class", 5) ? TokenType::Class : TokenType::Id;
+      case 'e':
+        if (isKeyword(id, "else", 4))
+          return TokenType::Else;
+        return isKeyword(id, "extern", 6) ? TokenType::Extern : TokenType::Id;
+      case 'f': return isKeyword(id, "false", 5) ? TokenType::False : TokenType::Id;
+      case 'i': return isKeyword(id, "if", 2) ? TokenType::If : TokenType::Id;
+      case 'n': return isKeyword(id, "null", 4) ? TokenType::Null : TokenType::Id;
+      case 'r': return isKeyword(id, "return", 6) ? TokenType::Return : TokenType::Id;
+      case 't': return isKeyword(id, "true", 4) ? TokenType::True : TokenType::Id;
+      default: return TokenType::Id;
     }
+  }
+}
 
-    if (accumulator.empty())
+TokenReader::TokenReader(std::string_view input)
+  : begin(input.data())
+  , end(input.data() + input.size())
+  , position(input.data())
+{
+  release_assert(input.size() < UINT32_MAX);
+}
+
+Token TokenReader::makeToken(TokenType type, const char* start, const char* tokenEnd)
+{
+  this->position = tokenEnd;
+
+  Token token;
+  token.type = type;
+  token.source = SourceRange(uint32_t(start - this->begin), uint32_t(tokenEnd - this->begin));
+  return token;
+}
+
+IntegerToken TokenReader::getInteger(const Token& token) const
+{
+  debug_assert(token.type == TokenType::IntegerToken);
+
+  IntegerToken result;
+  readInteger(this->begin + token.source.start, this->begin + token.source.end, result);
+  return result;
+}
+
+Token TokenReader::scan()
+{
+  const char* const end = this->end;
+  const char* p = this->position;
+
+  auto peekIs = [&](const char* position, char c)
+  {
+    return position < end && *position == c;
+  };
+
+  while (p < end)
+  {
+    const char* start = p;
+    uint8_t c = uint8_t(*p);
+
+    switch (charTables.classes[c])
     {
-      bool found = false;
+      case CharClass::Space:
+      {
+        p = Scan::skipWhitespace(p, end);
+        break;
+      }
 
-      for (const auto& pair : tokenMapping)
+      case CharClass::IdStart:
       {
-        std::string_view keyword = pair.first;
-        if (Str::startsWith(input, keyword))
-        {
-          SourceRange source({accumulatorX, accumulatorY}, {accumulatorX + int32_t(keyword.size()), accumulatorY});
-          tokens.push_back(Token{.type = pair.second, .source = source});
-          advance(keyword.size());
-          found = true;
-          break;
-        }
+        p = Scan::skipIdentifier(p + 1, end);
+        return makeToken(getKeywordOrId(std::string_view(start, p - start)), start, p);
       }
 
-      for (const auto& pair : keywordMapping)
+      case CharClass::Digit:
       {
-        std::string_view keyword = pair.first;
-        if (Str::startsWith(input, keyword))
+        IntegerToken unused;
+        p = readInteger(p, end, unused);
+        return makeToken(TokenType::IntegerToken, start, p);
+      }
+
+      case CharClass::Quote:
+      {
+        // the quotes and any escapes are kept, the c generator passes the whole thing through as a c string literal
+        p++;
+        while (true)
         {
-          bool keywordEnds = (input.size() >= keyword.size() + 1 && !Str::isAlpha(input[keyword.size()])) || input.size() == keyword.size();
-          if (keywordEnds)
+          p = Scan::findStringSpecial(p, end);
+          if (p == end)
+            break;
+
+          if (*p == '"')
           {
-            SourceRange source({accumulatorX, accumulatorY}, {accumulatorX + int32_t(keyword.size()), accumulatorY});
-            tokens.push_back(Token{.type = pair.second, .source = source});
-            advance(pair.first.size());
-            found = true;
+            p++;
             break;
           }
-        }
-      }
 
-      if (found)
-        continue;
+          // a backslash, skip over whatever it escapes, even if it's a quote
+          p++;
+          if (p == end)
+            break;
+          p++;
+        }
 
-      if (input[0] == '_' || Str::isAlpha(input[0]))
-      {
-        accumulate(input[0]);
-        accumulatorType = Type::Id;
-        advance(1);
-        continue;
-      }
-      else if (Str::isAlphaNumeric(input[0]))
-      {
-        accumulate(input[0]);
-        accumulatorType = Type::Integer;
-        integerSize = 32; // default
-        advance(1);
-        continue;
+        return makeToken(TokenType::String, start, p);
       }
-      else if (input[0] == '"')
-      {
-        accumulate(input[0]);
-        accumulatorType = Type::String;
-        escaped = false;
-        advance(1);
-      }
-      else
-      {
-        message_and_abort("invalid token");
-      }
-    }
 
-    if (accumulatorType == Type::Integer && !Str::isNumeric(input[0]))
-    {
-      if (input.starts_with("i64"))
+      case CharClass::Punctuation:
       {
-        integerSize = 64;
-        advance(3);
-      }
-      else if (input.starts_with("i32"))
-      {
-        integerSize = 32;
-        advance(3);
-      }
-      else if (input.starts_with("i16"))
-      {
-        integerSize = 16;
-        advance(3);
+        TokenType type = charTables.punctuation[c];
+        p++;
+
+        switch (c)
+        {
+          case '/':
+            if (peekIs(p, '/'))
+            {
+              // comment, runs until the newline
+              p = Scan::findNewline(p, end);
+              continue;
+            }
+            break;
+          case '=':
+            if (peekIs(p, '='))
+            {
+              type = TokenType::CompareEqual;
+              p++;
+            }
+            break;
+          case '!':
+            if (peekIs(p, '='))
+            {
+              type = TokenType::CompareNotEqual;
+              p++;
+            }
+            break;
+          case '&':
+            if (peekIs(p, '&'))
+            {
+              type = TokenType::LogicalAnd;
+              p++;
+            }
+            break;
+          case '|':
+            if (!peekIs(p, '|'))
+              message_and_abort("invalid token");
+            p++;
+            break;
+          default:
+            break;
+        }
+
+        return makeToken(type, start, p);
       }
-      else if (input.starts_with("i8"))
+
+      case CharClass::Invalid:
       {
-        integerSize = 8;
-        advance(2);
+        message_and_abort("invalid token");
       }
-
-      breakToken();
-      continue;
-    }
-    if (accumulatorType == Type::Id && !(Str::isAlphaNumeric(input[0]) || input[0] == '_'))
-    {
-      breakToken();
-      continue;
     }
-
-    accumulate(input[0]);
-    advance(1);
   }
 
-  breakToken();
-
-
-  SourceRange source({accumulatorX, accumulatorY}, {accumulatorX, accumulatorY});
-  tokens.push_back(Token{.type = Token::Type::End, .source = source});
-  return tokens;
+  return makeToken(TokenType::End, p, p);
 }
\ No newline at end of file
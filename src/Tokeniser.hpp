@@ -1,29 +1,20 @@
 #pragma once
 #include <vector>
 #include <string>
-#include <unordered_set>
+#include <string_view>
+#include <cstdint>
+#include "Common/Assert.hpp"
 
-struct SourceLocation
-{
-  int32_t y = -1;
-  int32_t x = -1;
-
-  SourceLocation() = default;
-  SourceLocation(int32_t x, int32_t y) : y(y), x(x) {}
-
-  bool operator>(SourceLocation other) const { return std::make_pair(y, x) > std::make_pair(other.y, other.x); }
-  bool operator>=(SourceLocation other) const { return std::make_pair(y, x) >= std::make_pair(other.y, other.x); }
-  bool operator<(SourceLocation other) const { return std::make_pair(y, x) < std::make_pair(other.y, other.x); }
-  bool operator<=(SourceLocation other) const { return std::make_pair(y, x) <= std::make_pair(other.y, other.x); }
-};
+// A byte offset into the file. Line and column are only worked out when a diagnostic needs them, see LineTable.
+using SourceLocation = uint32_t;
 
 struct SourceRange
 {
   SourceRange() = default;
   SourceRange(SourceLocation start, SourceLocation end) : start(start), end(end) {}
 
-  SourceLocation start;
-  SourceLocation end;
+  SourceLocation start = 0;
+  SourceLocation end = 0;
 
   bool isAfterEndOf(SourceRange other) const { return this->start >= other.end; }
 };
@@ -34,52 +25,101 @@ struct IntegerToken
   int32_t size = 0;
 };
 
-struct Token
+enum class TokenType : uint8_t
 {
-  enum class Type
-  {
-    Id,
-    IntegerToken,
-    String,
-    Comma,
-    OpenBracket,
-    CloseBracket,
-    OpenBrace,
-    CloseBrace,
-    OpenSquareBracket,
-    CloseSquareBracket,
-    CompareEqual,
-    CompareNotEqual,
-    LogicalAnd,
-    LogicalOr,
-    LogicalNot,
-    Return,
-    Semicolon,
-    Assign,
-    Add,
-    Subtract,
-    Asterisk,
-    Divide,
-    Class,
-    Dot,
-    If,
-    Else,
-    True,
-    False,
-    Extern,
-    Null,
-    Ampersand,
-    End
-  };
-
-  Type type = {};
-  std::string idValue = {};
-  IntegerToken integerValue;
-  std::string stringValue;
+  Id,
+  IntegerToken,
+  String,
+  Comma,
+  OpenBracket,
+  CloseBracket,
+  OpenBrace,
+  CloseBrace,
+  OpenSquareBracket,
+  CloseSquareBracket,
+  CompareEqual,
+  CompareNotEqual,
+  LogicalAnd,
+  LogicalOr,
+  LogicalNot,
+  Return,
+  Semicolon,
+  Assign,
+  Add,
+  Subtract,
+  Asterisk,
+  Divide,
+  Class,
+  Dot,
+  If,
+  Else,
+  True,
+  False,
+  Extern,
+  Null,
+  Ampersand,
+  End
+};
+
+using TT = TokenType;
 
+// Small enough to be passed around in registers. Payloads like integer values are decoded from the source text when
+// they're asked for.
+struct Token
+{
   SourceRange source;
+  TokenType type = TokenType::End;
 };
 
-using TT = Token::Type;
+// Tokenises on demand, so parsing can pull tokens straight out of the source without the whole file's tokens
+// existing at once. Only a few tokens of lookahead are kept, in a ring buffer. Once the input is used up, every
+// further token is End. The source must outlive the reader.
+class TokenReader
+{
+public:
+  explicit TokenReader(std::string_view input);
+
+  static constexpr uint32_t maxLookahead = 4;
+
+  const Token& peek(uint32_t ahead = 0)
+  {
+    debug_assert(ahead < maxLookahead);
+    while (this->count <= ahead)
+    {
+      this->lookahead[(this->head + this->count) % maxLookahead] = scan();
+      this->count++;
+    }
+    return this->lookahead[(this->head + ahead) % maxLookahead];
+  }
+
+  Token pop()
+  {
+    if (this->count == 0)
+      return scan();
+
+    Token token = this->lookahead[this->head];
+    this->head = (this->head + 1) % maxLookahead;
+    this->count--;
+    return token;
+  }
+
+  std::string_view getText(const Token& token) const
+  {
+    return std::string_view(this->begin + token.source.start, token.source.end - token.source.start);
+  }
+
+  IntegerToken getInteger(const Token& token) const;
+
+private:
+  Token scan();
+  Token makeToken(TokenType type, const char* start, const char* tokenEnd);
+
+private:
+  const char* begin;
+  const char* end;
+  const char* position;
 
-std::vector<Token> tokenise(std::string_view input);
\ No newline at end of file
+  Token lookahead[maxLookahead];
+  uint32_t head = 0;
+  uint32_t count = 0;
+};
\ No newline at end of file
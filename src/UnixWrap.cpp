@@ -1,6 +1,7 @@
 #if defined(__APPLE__) || defined(linux)
 #include "UnixWrap.hpp"
 #include <unistd.h>
+#include <sys/wait.h>
 #include <cerrno>
 
 #ifdef __APPLE__
@@ -52,4 +53,24 @@ int w_dup2(int oldfd, int newfd)
   }
 }
 
+int w_poll(struct pollfd* fds, nfds_t count, int timeout)
+{
+  while (true)
+  {
+    int ret = poll(fds, count, timeout);
+    if (ret != -1 || errno != EINTR)
+      return ret;
+  }
+}
+
+pid_t w_waitpid(pid_t pid, int* status, int options)
+{
+  while (true)
+  {
+    pid_t ret = waitpid(pid, status, options);
+    if (ret != -1 || errno != EINTR)
+      return ret;
+  }
+}
+
 #endif
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
 #if defined(__APPLE__) || defined(linux)
 #include <cstdio>
+#include <poll.h>
+#include <sys/types.h>
 
 int w_close(int fd);
 ssize_t w_read(int fd, void* buf, size_t size);
 ssize_t	w_write(int fd, const void* buf, size_t size);
 int w_dup2(int oldfd, int newfd);
+int w_poll(struct pollfd* fds, nfds_t count, int timeout);
+pid_t w_waitpid(pid_t pid, int* status, int options);
 
 #endif
\ No newline at end of file
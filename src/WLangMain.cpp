@@ -1,96 +1,558 @@
-#include "Tokeniser.hpp"
-#include "Parser.hpp"
 #include "PlainCGenerator.hpp"
 #include "SemanticAnalyser.hpp"
 #include "MergedAst.hpp"
 #include "Common/Filesystem.hpp"
+#include "Common/StringUtil.hpp"
 #include "Process.hpp"
 #include "CCompiler.hpp"
 #include "CCompilerMSVC.hpp"
 #include "CCompilerClang.hpp"
-#include "ClassDefaultsGenerator.hpp"
+#include "Parallel.hpp"
+#include "BuildManifest.hpp"
+#include "Common/Hash.hpp"
+#include "BuildProfile.hpp"
+#include "JobServer.hpp"
+#include "SourceLoader.hpp"
+#include <optional>
 
-int WLangMain(int argc, char** argv)
+static void printUsage()
 {
-  fs::path projectRoot;
-  if (argc > 1)
-    projectRoot = argv[1];
-  else
-    projectRoot = fs::current_path();
+  fprintf(stderr, "usage: wlang [-j N] [--tu function|file|unity] [--no-shared-header] [--profile NAME] [--lto none|full|thin] [--march ARCH] [--pgo-merge] [--keep-c] [project root]\n");
+  fprintf(stderr, "profiles:");
+  for (const BuildProfile& profile : BuildProfile::getAll())
+    fprintf(stderr, " %s", profile.name.c_str());
+  fprintf(stderr, "\n");
+}
 
-  MergedAst mergedAst;
+static uint64_t hashCommand(const std::vector<std::string>& command)
+{
+  std::string commandLine;
+  for (const std::string& arg : command)
+  {
+    commandLine += arg;
+    commandLine += '\0';
+  }
+  return hashString(commandLine);
+}
+
+// How generated functions are grouped into C translation units.
+// Smaller units mean less to recompile after an edit, larger ones avoid re-parsing the same declarations over and over.
+enum class TranslationUnitMode
+{
+  Function, // one per function
+  File,     // one per source file
+  Unity,    // one for the whole program
+};
+
+static std::string getFileTranslationUnitName(const AstChunk* chunk)
+{
+  std::string name;
+  for (char c : fs::path(chunk->path).stem().string())
+    name += Str::isAlphaNumeric(c) ? c : '_';
+
+  // file names aren't unique across directories, so disambiguate with the full path
+  char hash[16];
+  snprintf(hash, sizeof(hash), "_%08x", uint32_t(hashString(chunk->path)));
+  return "file_" + name + hash;
+}
 
-  auto add = [&](std::string_view path, std::string_view inputString)
+// Instrumented binaries from the pgo-generate profile write their raw profiles here
+static fs::path getRawProfileDirectory(const fs::path& projectRoot)
+{
+  return projectRoot / BuildProfile::get("pgo-generate")->getBuildDirectoryName() / "profraw";
+}
+
+// The pgo-use profile reads the merged profile from here. Alongside it is a copy of the pgo-generate manifest, so we
+// know which version of each translation unit the profile describes.
+static fs::path getMergedProfilePath(const fs::path& projectRoot)
+{
+  return projectRoot / BuildProfile::get("pgo-use")->getBuildDirectoryName() / "wlang.profdata";
+}
+
+static fs::path getProfiledUnitsPath(const fs::path& projectRoot)
+{
+  return getMergedProfilePath(projectRoot).string() + ".units";
+}
+
+static int mergeProfileData(CCompiler& cCompiler, const fs::path& projectRoot)
+{
+  if (!cCompiler.supportsProfileGuidedOptimisation())
   {
-    AstChunk* ast = mergedAst.create(path);
-    std::vector<Token> tokens = tokenise(inputString);
-    parse(*ast, tokens);
-    generateClassDefaults(*ast);
-    mergedAst.link(ast);
-  };
+    fprintf(stderr, "profile guided optimisation is not supported by this compiler\n");
+    return 1;
+  }
 
-  for (fs::path path : fs::recursive_directory_iterator(projectRoot / "src"))
+  std::vector<fs::path> rawProfilePaths;
+  std::error_code error;
+  for (const fs::directory_entry& entry : fs::directory_iterator(getRawProfileDirectory(projectRoot), error))
   {
-    if (path.extension() == ".w")
+    if (entry.path().extension() == ".profraw")
+      rawProfilePaths.emplace_back(entry.path());
+  }
+
+  if (rawProfilePaths.empty())
+  {
+    fprintf(stderr, "no raw profiles in %s, build with --profile pgo-generate and run the result first\n", getRawProfileDirectory(projectRoot).string().c_str());
+    return 1;
+  }
+  std::sort(rawProfilePaths.begin(), rawProfilePaths.end());
+
+  fs::path mergedProfilePath = getMergedProfilePath(projectRoot);
+  fs::create_directories(mergedProfilePath.parent_path(), error);
+
+  std::string errorOutput;
+  if (!cCompiler.mergeProfileData(rawProfilePaths, mergedProfilePath, errorOutput))
+  {
+    fprintf(stderr, "failed to merge profile data:\n%s\n", errorOutput.c_str());
+    return 1;
+  }
+
+  BuildManifest generateManifest;
+  generateManifest.load(projectRoot / BuildProfile::get("pgo-generate")->getBuildDirectoryName() / "manifest.txt");
+  release_assert(generateManifest.save(getProfiledUnitsPath(projectRoot)));
+
+  return 0;
+}
+
+int WLangMain(int argc, char** argv)
+{
+  fs::path projectRoot = fs::current_path();
+  int32_t jobs = getHardwareThreadCount();
+  bool jobsSpecified = false;
+  TranslationUnitMode translationUnitMode = TranslationUnitMode::Function;
+  bool useSharedHeader = true;
+  BuildProfile profile = *BuildProfile::get("debug");
+  std::optional<std::string> marchOverride;
+  std::optional<BuildProfile::LtoMode> ltoOverride;
+  bool pgoMerge = false;
+  bool keepCFiles = false;
+
+  for (int32_t i = 1; i < argc; i++)
+  {
+    std::string_view arg = argv[i];
+    if (arg.starts_with("-j"))
     {
-      std::string data;
-      release_assert(readWholeFileAsString(path, data));
-      add(path.string(), data);
+      std::string_view value = arg.substr(2);
+      if (value.empty() && i + 1 < argc)
+        value = argv[++i];
+
+      jobs = Str::isNumeric(value) && value.size() < 6 ? std::stoi(std::string(value)) : 0;
+      if (jobs < 1)
+      {
+        printUsage();
+        return 1;
+      }
+      jobsSpecified = true;
+    }
+    else if (arg == "--tu" && i + 1 < argc)
+    {
+      std::string_view value = argv[++i];
+      if (value == "function")
+        translationUnitMode = TranslationUnitMode::Function;
+      else if (value == "file")
+        translationUnitMode = TranslationUnitMode::File;
+      else if (value == "unity")
+        translationUnitMode = TranslationUnitMode::Unity;
+      else
+      {
+        printUsage();
+        return 1;
+      }
+    }
+    else if (arg == "--no-shared-header")
+    {
+      useSharedHeader = false;
+    }
+    else if (arg == "--profile" && i + 1 < argc)
+    {
+      const BuildProfile* namedProfile = BuildProfile::get(argv[++i]);
+      if (!namedProfile)
+      {
+        printUsage();
+        return 1;
+      }
+      profile = *namedProfile;
+    }
+    else if (arg == "--lto" && i + 1 < argc)
+    {
+      BuildProfile::LtoMode ltoMode;
+      if (!BuildProfile::parseLtoMode(argv[++i], ltoMode))
+      {
+        printUsage();
+        return 1;
+      }
+      ltoOverride = ltoMode;
+    }
+    else if (arg == "--march" && i + 1 < argc)
+    {
+      marchOverride = argv[++i];
+    }
+    else if (arg == "--keep-c")
+    {
+      keepCFiles = true;
+    }
+    else if (arg == "--pgo-merge")
+    {
+      pgoMerge = true;
+    }
+    else if (arg.starts_with("-"))
+    {
+      printUsage();
+      return 1;
+    }
+    else
+    {
+      projectRoot = arg;
     }
   }
 
+  if (marchOverride)
+    profile.march = *marchOverride;
+  if (ltoOverride)
+    profile.lto = *ltoOverride;
+
+  std::unique_ptr<CCompiler> cCompiler = std::unique_ptr<CCompiler>(
+#if WIN32
+    new CCompilerMSVC()
+#else
+    new CCompilerClang()
+#endif
+    );
+
+  if (pgoMerge)
+    return mergeProfileData(*cCompiler, projectRoot);
+
   std::filesystem::path compilerRootPath = getPathToThisExecutable();
   while (!std::filesystem::exists(compilerRootPath / "stdlib" ))
     compilerRootPath = compilerRootPath.parent_path();
 
-  for (fs::path path : fs::recursive_directory_iterator(compilerRootPath / "stdlib"))
+  // sorted, because directory iteration order isn't specified and link order decides mangled names
+  std::vector<fs::path> sourcePaths;
+  for (const fs::path& directory : {projectRoot / "src", compilerRootPath / "stdlib"})
   {
-    if (path.extension() == ".w")
+    size_t directoryStart = sourcePaths.size();
+    for (fs::path path : fs::recursive_directory_iterator(directory))
     {
-      std::string data;
-      release_assert(readWholeFileAsString(path, data));
-      add(path.string(), data);
+      if (path.extension() == ".w")
+        sourcePaths.emplace_back(std::move(path));
     }
+    std::sort(sourcePaths.begin() + directoryStart, sourcePaths.end());
   }
 
+  MergedAst mergedAst;
+
+  // files are parsed on worker threads, and linked here as each one is finished
+  loadSources(sourcePaths, jobs, [&](std::unique_ptr<AstChunk> chunk)
+  {
+    mergedAst.link(mergedAst.add(std::move(chunk)));
+  });
+
   SemanticAnalyser semanticAnalyser;
   semanticAnalyser.run(mergedAst);
 
-  fs::path buildDirectory = projectRoot / "build_debug";
+  fs::path buildDirectory = projectRoot / profile.getBuildDirectoryName();
 
   std::error_code _;
   fs::create_directories(buildDirectory, _);
 
-  std::unique_ptr<CCompiler> cCompiler = std::unique_ptr<CCompiler>(
-#if WIN32
-    new CCompilerMSVC()
-#else
-    new CCompilerClang()
-#endif
-    );
-  std::vector<fs::path> objects;
+  if (profile.pgo != BuildProfile::Pgo::None && !cCompiler->supportsProfileGuidedOptimisation())
+  {
+    fprintf(stderr, "profile guided optimisation is not supported by this compiler\n");
+    return 1;
+  }
+
+  // Units that changed since the profile was recorded get compiled with this instead, the profile would only mislead
+  // the optimiser about them
+  BuildProfile unprofiledProfile = profile;
+  unprofiledProfile.pgo = BuildProfile::Pgo::None;
+
+  BuildManifest profiledUnits;
+  uint64_t profileDataHash = 0;
+  if (profile.pgo == BuildProfile::Pgo::Generate)
+  {
+    profile.profileDataPath = getRawProfileDirectory(projectRoot).string();
+    fs::create_directories(profile.profileDataPath, _);
+  }
+  else if (profile.pgo == BuildProfile::Pgo::Use)
+  {
+    profile.profileDataPath = getMergedProfilePath(projectRoot).string();
+
+    std::string profileData;
+    if (!readWholeFileAsString(profile.profileDataPath, profileData))
+    {
+      fprintf(stderr, "no profile data at %s, run wlang --pgo-merge first\n", profile.profileDataPath.c_str());
+      return 1;
+    }
+    profileDataHash = hashString(profileData);
+    profiledUnits.load(getProfiledUnitsPath(projectRoot));
+  }
 
+  struct CompileJob
+  {
+    std::string name;
+    std::vector<std::pair<const AstChunk*, const Func*>> functions; // with the chunk each one's body is in
+    fs::path cFile;
+    fs::path objectFile;
+    std::string source;
+    const BuildProfile* profile = nullptr;
+    BuildManifest::Entry manifestEntry;
+    bool upToDate = false;
+    bool rebuilt = false;
+    bool failed = false;
+    std::string errorOutput;
+  };
+
+  std::vector<const AstChunk*> chunks;
   for (const AstChunk* chunk : mergedAst)
+    chunks.emplace_back(chunk);
+  std::sort(chunks.begin(), chunks.end(), [](const AstChunk* a, const AstChunk* b) { return a->path < b->path; });
+
+  std::vector<CompileJob> compileJobs;
+  auto addToJob = [&](std::string_view name, const AstChunk* chunk, const Func* function)
+  {
+    // extern functions have no body, so there's nothing to compile
+    if (function->external)
+      return;
+
+    if (compileJobs.empty() || compileJobs.back().name != name)
+    {
+      CompileJob& job = compileJobs.emplace_back();
+      job.name = name;
+      job.cFile = buildDirectory / (job.name + ".c");
+      job.objectFile = buildDirectory / (job.name + ".o");
+    }
+    compileJobs.back().functions.emplace_back(chunk, function);
+  };
+
+  for (const AstChunk* chunk : chunks)
   {
+    std::string fileName = getFileTranslationUnitName(chunk);
+
     for (const Func* function : chunk->root->funcList->functions)
     {
-      PlainCGenerator generator;
-      generator.generate(function);
-      std::string output = generator.output();
-      fs::path outputCFile = buildDirectory / (function->mangledName + ".c");
-      fs::path outputObjFile = buildDirectory / (function->mangledName + ".o");
-      release_assert(overwriteFileWithString(outputCFile, output));
+      switch (translationUnitMode)
+      {
+        case TranslationUnitMode::Function:
+          addToJob(function->mangledName.str(), chunk, function);
+          break;
+        case TranslationUnitMode::File:
+          addToJob(fileName, chunk, function);
+          break;
+        case TranslationUnitMode::Unity:
+          addToJob("unity", chunk, function);
+          break;
+      }
+    }
+  }
+
+  fs::path manifestPath = buildDirectory / "manifest.txt";
+  BuildManifest manifest;
+  manifest.load(manifestPath);
+
+  // Class layouts and prototypes for the whole program go in one header, so each translation unit doesn't have to repeat
+  // them. If the compiler can, we precompile it once up front. Function bodies aren't in it, so editing one doesn't
+  // invalidate the precompiled header.
+  std::string sharedHeaderName = "wlang_types.h";
+  uint64_t sharedHeaderHash = 0;
+  fs::path precompiledHeaderPath;
+  if (useSharedHeader)
+  {
+    PlainCGenerator headerGenerator;
+    for (const AstChunk* chunk : chunks)
+      headerGenerator.declare(chunk->root);
+    std::string header = headerGenerator.outputSharedHeader();
+    sharedHeaderHash = hashString(header);
+
+    // clang checks the header's timestamp when loading the precompiled version, so don't touch it unless we have to
+    fs::path sharedHeaderPath = buildDirectory / sharedHeaderName;
+    std::string oldHeader;
+    if (!readWholeFileAsString(sharedHeaderPath, oldHeader) || oldHeader != header)
+      release_assert(overwriteFileWithString(sharedHeaderPath, header));
+
+    if (cCompiler->supportsPrecompiledHeaders())
+    {
+      std::string precompiledHeaderName = sharedHeaderName + ".pch";
+      precompiledHeaderPath = buildDirectory / precompiledHeaderName;
+
+      BuildManifest::Entry entry =
+      {
+        .sourceHash = sharedHeaderHash,
+        .commandHash = hashCommand(cCompiler->getPrecompileHeaderCommand(profile, sharedHeaderPath, precompiledHeaderPath)),
+      };
+
+      if (!manifest.isUpToDate(precompiledHeaderName, entry, precompiledHeaderPath))
+      {
+        manifest.remove(precompiledHeaderName);
+        release_assert(manifest.save(manifestPath));
+
+        std::string errorOutput;
+        if (!cCompiler->precompileHeader(profile, sharedHeaderPath, precompiledHeaderPath, errorOutput))
+        {
+          fprintf(stderr, "failed to precompile %s:\n%s\n", sharedHeaderName.c_str(), errorOutput.c_str());
+          return 1;
+        }
+
+        manifest.set(precompiledHeaderName, entry);
+      }
+    }
+  }
+
+  // The .c files would only be written out for the compiler to read straight back in, so unless they're wanted for
+  // debugging, pipe the source in instead
+  bool compileFromStdin = !keepCFiles && cCompiler->supportsCompilingFromStdin();
+  auto getCompileCommand = [&](const CompileJob& job)
+  {
+    if (compileFromStdin)
+      return cCompiler->getCompileFromStdinCommand(*job.profile, job.objectFile, precompiledHeaderPath, buildDirectory);
+    return cCompiler->getCompileCommand(*job.profile, job.cFile, job.objectFile, precompiledHeaderPath);
+  };
+
+  // Generate everything up front, so we know which objects can be reused from the last build
+  release_assert(parallelFor(int32_t(compileJobs.size()), jobs, [&](int32_t i)
+  {
+    CompileJob& job = compileJobs[i];
+
+    PlainCGenerator generator;
+    for (const auto& [chunk, function] : job.functions)
+      generator.generate(*chunk, function);
+    job.source = useSharedHeader ? generator.output(sharedHeaderName) : generator.output();
+
+    // if we include the shared header, then its contents count as part of our source too
+    uint64_t sourceHash = hashString(job.source, sharedHeaderHash);
+
+    job.profile = &profile;
+    if (profile.pgo == BuildProfile::Pgo::Use)
+    {
+      // likewise for the profile data, but it's only any use if it was recorded against this exact source
+      const BuildManifest::Entry* profiledUnit = profiledUnits.get(job.name);
+      if (profiledUnit && profiledUnit->sourceHash == sourceHash)
+        sourceHash = hashString(job.source, hashString(std::string_view((const char*)&profileDataHash, sizeof(profileDataHash)), sharedHeaderHash));
+      else
+        job.profile = &unprofiledProfile;
+    }
+
+    job.manifestEntry =
+    {
+      .sourceHash = sourceHash,
+      .commandHash = hashCommand(getCompileCommand(job)),
+    };
+    job.upToDate = manifest.isUpToDate(job.name, job.manifestEntry, job.objectFile);
+    if (job.upToDate)
+      job.source = std::string();
+    return true;
+  }));
+
+  std::vector<CompileJob*> staleJobs;
+  for (CompileJob& job : compileJobs)
+  {
+    if (job.profile == &unprofiledProfile)
+      fprintf(stderr, "warning: %s changed since its profile data was recorded, building it without\n", job.name.c_str());
+
+    if (!job.upToDate)
+      staleJobs.emplace_back(&job);
+  }
+
+  if (!staleJobs.empty())
+  {
+    // Forget about objects before we overwrite them, so getting interrupted mid-build can't leave a manifest that lies
+    for (const CompileJob* job : staleJobs)
+      manifest.remove(job->name);
+    release_assert(manifest.save(manifestPath));
+  }
+
+  // Every function is compiled independently, so they can all run concurrently. The compilers do the work, so one
+  // thread launching them and collecting their output is enough to keep them all busy.
+  bool compiled = true;
+  {
+    JobServer jobServer(jobs);
+
+    // an explicit -j overrides make's jobserver, like it does for a sub-make
+    const char* makeFlags = jobsSpecified ? nullptr : getenv("MAKEFLAGS");
+    std::string jobServerError;
+    if (makeFlags && !jobServer.connectToMake(makeFlags, jobServerError) && !jobServerError.empty())
+      fprintf(stderr, "warning: %s, running one compile at a time\n", jobServerError.c_str());
+
+    ProcessPool processPool;
+    size_t nextJob = 0;
+    while (true)
+    {
+      while (compiled && nextJob < staleJobs.size() && jobServer.tryAcquire())
+      {
+        CompileJob& job = *staleJobs[nextJob];
+        if (compileFromStdin)
+        {
+          processPool.launchWithInput(nextJob, getCompileCommand(job), job.source);
+        }
+        else
+        {
+          release_assert(overwriteFileWithString(job.cFile, job.source));
+          processPool.launch(nextJob, getCompileCommand(job));
+        }
+        nextJob++;
+      }
+
+      // if there's more to start, also wake up when make might have a token for us
+      int wakeFd = compiled && nextJob < staleJobs.size() ? jobServer.getWaitFd() : -1;
+
+      ProcessCompletion completion;
+      ProcessPool::WaitResult result = processPool.wait(completion, wakeFd);
+      if (result == ProcessPool::WaitResult::NothingRunning)
+        break;
+      if (result == ProcessPool::WaitResult::Woken)
+        continue;
+
+      jobServer.release();
 
-      cCompiler->compile(outputCFile, outputObjFile);
-      objects.emplace_back(std::move(outputObjFile));
+      CompileJob& job = *staleJobs[completion.id];
+      job.failed = !completion.launched || completion.exitCode != 0;
+      job.rebuilt = !job.failed;
+      job.errorOutput = std::move(completion.output);
+      if (!completion.launched)
+        job.errorOutput = "couldn't run " + formatCommand(getCompileCommand(job));
+
+      // once something fails, let what's already running finish, but don't start anything new
+      if (job.failed)
+        compiled = false;
     }
   }
 
+  for (const CompileJob* job : staleJobs)
+  {
+    if (job->rebuilt)
+      manifest.set(job->name, job->manifestEntry);
+  }
+
+  if (!staleJobs.empty())
+    release_assert(manifest.save(manifestPath));
+
+  if (!compiled)
+  {
+    for (const CompileJob* job : staleJobs)
+    {
+      if (job->failed)
+      {
+        fprintf(stderr, "failed to compile %s:\n%s\n", job->name.c_str(), job->errorOutput.c_str());
+        break;
+      }
+    }
+    return 1;
+  }
+
+  std::vector<fs::path> objects;
+  objects.reserve(compileJobs.size());
+  for (CompileJob& job : compileJobs)
+    objects.emplace_back(std::move(job.objectFile));
+
   std::string exeFilename = "main";
 #if WIN32
   exeFilename += ".exe";
 #endif
-  cCompiler->linkExecutable(objects, buildDirectory / exeFilename);
+  std::string errorOutput;
+  if (!cCompiler->linkExecutable(profile, objects, buildDirectory / exeFilename, errorOutput))
+  {
+    fprintf(stderr, "failed to link:\n%s\n", errorOutput.c_str());
+    return 1;
+  }
 
   return 0;
 }
\ No newline at end of file